@@ -0,0 +1,251 @@
+#include "Augment.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace AUGMENT_MNIST {
+    namespace {
+        std::uint64_t mix(std::uint64_t x) {
+            x += 0x9e3779b97f4a7c15ull;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+        }
+
+        // SplitMix64, cheap enough to seed per sample.
+        class SampleRng {
+        public:
+            SampleRng(const std::uint64_t seed, const std::uint64_t epoch, const int sample) :
+                state_(mix(seed ^ mix(epoch ^ mix(static_cast<std::uint64_t>(sample))))) {
+            }
+
+            std::uint64_t next() {
+                return mix(state_ += 0x9e3779b97f4a7c15ull);
+            }
+
+            // [0, 1)
+            float uniform() {
+                return static_cast<float>(next() >> 40) * 0x1p-24f;
+            }
+
+            float symmetric(const float max) {
+                return (2.0f * uniform() - 1.0f) * max;
+            }
+
+        private:
+            std::uint64_t state_;
+        };
+
+        struct FloatRows {
+            const Eigen::Ref<const RowMatrixXf> &images;
+
+            float operator()(const int sample, const int pixel) const { return images(sample, pixel); }
+        };
+
+        struct DoubleRows {
+            const Eigen::MatrixXd &images;
+
+            float operator()(const int sample, const int pixel) const {
+                return static_cast<float>(images(sample, pixel));
+            }
+        };
+
+        // Per thread buffers, allocated once per call and reused for every image of the thread.
+        struct Scratch {
+            // source image with a zero border of 1 pixel before and 2 after, clamped
+            // coordinates never leave it so sampling needs no bounds checks
+            std::vector<float> padded;
+            std::vector<float> grid;
+            std::vector<float> rowDx;
+            std::vector<float> rowDy;
+            Eigen::ArrayXf dx, dy, sx, sy, fx, fy, wx, wy, noise;
+            Eigen::ArrayXi ix, iy;
+
+            Scratch(const int rows, const int cols, const int grid) :
+                padded(static_cast<size_t>(rows + 3) * (cols + 3), 0.0f),
+                grid(2 * static_cast<size_t>(grid + 1) * (grid + 1)),
+                rowDx(grid + 1), rowDy(grid + 1),
+                dx(Eigen::ArrayXf::Zero(cols)), dy(Eigen::ArrayXf::Zero(cols)),
+                sx(cols), sy(cols), fx(cols), fy(cols), wx(cols), wy(cols), noise(cols), ix(cols), iy(cols) {
+            }
+        };
+
+        void checkBatch(const Eigen::Index rows, const Eigen::Index cols, const int pixels, const int first,
+                        const int count) {
+            if (cols != pixels) {
+                throw std::invalid_argument("Image size does not match the augmenter");
+            }
+            if (first < 0 || count < 0 || first + count > rows) {
+                throw std::out_of_range("Batch out of range");
+            }
+        }
+    }
+
+    Augmenter::Augmenter(const int rows, const int cols, const AugmentConfig &config, const int numThreads) :
+        rows_(rows),
+        cols_(cols),
+        config_(config),
+        numThreads_(numThreads > 0 ? numThreads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))) {
+        if (rows <= 0 || cols <= 0) {
+            throw std::invalid_argument("Image size must be positive");
+        }
+        if (config_.elasticGrid < 1) {
+            throw std::invalid_argument("elasticGrid must be at least 1");
+        }
+        xs_ = Eigen::ArrayXf::LinSpaced(cols, 0.0f, static_cast<float>(cols - 1));
+
+        // control point k sits at k * (size - 1) / grid
+        const int grid = config_.elasticGrid;
+        auto place = [grid](const int i, const int size, int &cell, float &frac) {
+            const float t = size > 1 ? static_cast<float>(i) * static_cast<float>(grid) / static_cast<float>(size - 1) : 0.0f;
+            cell = std::min(static_cast<int>(t), grid - 1);
+            frac = t - static_cast<float>(cell);
+        };
+        gridCol_.resize(cols);
+        gridColFrac_.resize(cols);
+        for (int x = 0; x < cols; ++x) {
+            place(x, cols, gridCol_[x], gridColFrac_[x]);
+        }
+        gridRow_.resize(rows);
+        gridRowFrac_.resize(rows);
+        for (int y = 0; y < rows; ++y) {
+            place(y, rows, gridRow_[y], gridRowFrac_[y]);
+        }
+    }
+
+    void Augmenter::augment(const Eigen::Ref<const RowMatrixXf> &images, const int first, const int count,
+                            const std::uint64_t epoch, RowMatrixXf &out) const {
+        checkBatch(images.rows(), images.cols(), rows_ * cols_, first, count);
+        run(FloatRows{images}, first, count, epoch, out);
+    }
+
+    void Augmenter::augmentFromDouble(const Eigen::MatrixXd &images, const int first, const int count,
+                                      const std::uint64_t epoch, RowMatrixXf &out) const {
+        checkBatch(images.rows(), images.cols(), rows_ * cols_, first, count);
+        run(DoubleRows{images}, first, count, epoch, out);
+    }
+
+    const RowMatrixXf &Augmenter::batch(const Eigen::Ref<const RowMatrixXf> &images, const int first,
+                                        const int count, const std::uint64_t epoch) {
+        augment(images, first, count, epoch, buffer_);
+        return buffer_;
+    }
+
+    template<class Source>
+    void Augmenter::run(const Source &source, const int first, const int count, const std::uint64_t epoch,
+                        RowMatrixXf &out) const {
+        if (out.rows() != count || out.cols() != rows_ * cols_) {
+            out.resize(count, rows_ * cols_);
+        }
+        const int grid = config_.elasticGrid;
+        const int stride = cols_ + 3;
+        const float cx = 0.5f * static_cast<float>(cols_ - 1);
+        const float cy = 0.5f * static_cast<float>(rows_ - 1);
+
+        auto augmentOne = [&](Scratch &s, const int sample, float *dst) {
+            SampleRng rng(config_.seed, epoch, sample);
+            const float angle = rng.symmetric(config_.maxRotation);
+            const float scale = 1.0f + rng.symmetric(config_.maxScale);
+            const float shear = rng.symmetric(config_.maxShear);
+            const float tx = rng.symmetric(config_.maxShift);
+            const float ty = rng.symmetric(config_.maxShift);
+
+            // source = centre + R(angle) [scale shear; 0 scale] (target - centre) - shift
+            const float c = std::cos(angle);
+            const float sn = std::sin(angle);
+            const float m00 = c * scale;
+            const float m01 = c * shear - sn * scale;
+            const float m10 = sn * scale;
+            const float m11 = sn * shear + c * scale;
+
+            for (int y = 0; y < rows_; ++y) {
+                float *row = s.padded.data() + static_cast<size_t>(y + 1) * stride + 1;
+                for (int x = 0; x < cols_; ++x) {
+                    row[x] = source(sample, y * cols_ + x);
+                }
+            }
+            const bool elastic = config_.elasticAlpha > 0.0f;
+            if (elastic) {
+                for (float &g: s.grid) {
+                    g = rng.symmetric(config_.elasticAlpha);
+                }
+            }
+
+            for (int y = 0; y < rows_; ++y) {
+                if (elastic) {
+                    // interpolate the control grid to this row, then along the row
+                    const int points = grid + 1;
+                    const float *gx = s.grid.data() + static_cast<size_t>(gridRow_[y]) * points;
+                    const float *gy = gx + static_cast<size_t>(points) * points;
+                    const float fr = gridRowFrac_[y];
+                    for (int k = 0; k < points; ++k) {
+                        s.rowDx[k] = gx[k] + fr * (gx[k + points] - gx[k]);
+                        s.rowDy[k] = gy[k] + fr * (gy[k + points] - gy[k]);
+                    }
+                    for (int x = 0; x < cols_; ++x) {
+                        const int k = gridCol_[x];
+                        s.dx[x] = s.rowDx[k] + gridColFrac_[x] * (s.rowDx[k + 1] - s.rowDx[k]);
+                        s.dy[x] = s.rowDy[k] + gridColFrac_[x] * (s.rowDy[k + 1] - s.rowDy[k]);
+                    }
+                }
+                const float ry = static_cast<float>(y) - cy;
+                s.sx = (m00 * xs_ + (cx - m00 * cx + m01 * ry - tx) + s.dx).max(-1.0f).min(static_cast<float>(cols_));
+                s.sy = (m10 * xs_ + (cy - m10 * cx + m11 * ry - ty) + s.dy).max(-1.0f).min(static_cast<float>(rows_));
+                s.fx = s.sx.floor();
+                s.fy = s.sy.floor();
+                s.wx = s.sx - s.fx;
+                s.wy = s.sy - s.fy;
+                s.ix = s.fx.cast<int>();
+                s.iy = s.fy.cast<int>();
+
+                // branch free gather and blend, vectorised with gathers where the ISA has them
+                const float *p = s.padded.data();
+                float *out_row = dst + static_cast<size_t>(y) * cols_;
+                for (int x = 0; x < cols_; ++x) {
+                    const int base = (s.iy[x] + 1) * stride + s.ix[x] + 1;
+                    const float top = p[base] + s.wx[x] * (p[base + 1] - p[base]);
+                    const float bottom = p[base + stride] + s.wx[x] * (p[base + stride + 1] - p[base + stride]);
+                    out_row[x] = top + s.wy[x] * (bottom - top);
+                }
+
+                if (config_.noiseStddev > 0.0f) {
+                    // sum of four 16 bit uniforms from one draw, close enough to a normal for noise
+                    // and a fraction of the cost of Box-Muller
+                    const float unit = config_.noiseStddev * std::sqrt(3.0f) * 0x1p-16f;
+                    for (int x = 0; x < cols_; ++x) {
+                        const std::uint64_t bits = rng.next();
+                        const auto sum = static_cast<float>((bits & 0xffff) + (bits >> 16 & 0xffff)
+                                                            + (bits >> 32 & 0xffff) + (bits >> 48));
+                        s.noise[x] = (sum - 2.0f * 0xffffp0f) * unit;
+                    }
+                    Eigen::Map<Eigen::ArrayXf> values(out_row, cols_);
+                    values = (values + s.noise).max(0.0f).min(1.0f);
+                }
+            }
+        };
+
+        // chunks of a few images are handed out dynamically, each thread keeps its scratch
+        constexpr int chunk = 8;
+        const int chunks = (count + chunk - 1) / chunk;
+        const int threads = std::max(1, std::min(numThreads_, chunks));
+        std::atomic<int> next{0};
+        auto worker = [&]() {
+            Scratch scratch(rows_, cols_, grid);
+            for (int b = next++; b < chunks; b = next++) {
+                for (int i = b * chunk; i < std::min(count, (b + 1) * chunk); ++i) {
+                    augmentOne(scratch, first + i, out.row(i).data());
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; ++t) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto &thread: pool) {
+            thread.join();
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef AUGMENT_HPP
+#define AUGMENT_HPP
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace AUGMENT_MNIST {
+    using RowMatrixXf = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    // Ranges of the random transformations, every parameter is drawn uniformly from [-max, max]
+    // per sample. A range of 0 disables the transformation, all zero is the identity.
+    struct AugmentConfig {
+        float maxShift = 2.0f;      // pixels
+        float maxRotation = 0.2f;   // radians
+        float maxScale = 0.1f;      // relative to the image size
+        float maxShear = 0.1f;
+        // Elastic distortion: displacements of up to elasticAlpha pixels on an elasticGrid x elasticGrid
+        // control grid, bilinearly interpolated to a smooth field over the image.
+        float elasticAlpha = 1.5f;
+        int elasticGrid = 4;
+        // Approximately gaussian pixel noise, the result is clamped to [0, 1].
+        float noiseStddev = 0.02f;
+        std::uint64_t seed = 42;
+    };
+
+    // On-the-fly augmentation of MNIST batches.
+    // Every image is warped by a random affine transform plus an elastic field and resampled
+    // bilinearly, a whole output row at a time so coordinates, weights and blending vectorise.
+    // Sample i of an epoch always gets the same parameters, whatever the batch boundaries or
+    // the number of worker threads.
+    class Augmenter {
+    public:
+        // numThreads = 0 uses all hardware threads, each thread handles its own chunks of the batch
+        Augmenter(int rows, int cols, const AugmentConfig &config = {}, int numThreads = 0);
+
+        // Augments images [first, first + count) into the rows of out, e.g. from MnistCache::images().
+        // out is only reallocated if the batch shape changes.
+        void augment(const Eigen::Ref<const RowMatrixXf> &images, int first, int count, std::uint64_t epoch,
+                     RowMatrixXf &out) const;
+
+        // Same for images as returned by IO_MNIST::loadMnistImages, converted while they are read.
+        void augmentFromDouble(const Eigen::MatrixXd &images, int first, int count, std::uint64_t epoch,
+                               RowMatrixXf &out) const;
+
+        // Augmented batch in a buffer owned by the augmenter, valid until the next call.
+        const RowMatrixXf &batch(const Eigen::Ref<const RowMatrixXf> &images, int first, int count,
+                                 std::uint64_t epoch);
+
+        [[nodiscard]] int numThreads() const { return numThreads_; }
+        [[nodiscard]] const AugmentConfig &config() const { return config_; }
+
+    private:
+        int rows_;
+        int cols_;
+        AugmentConfig config_;
+        int numThreads_;
+        // column coordinates and where they fall on the elastic control grid
+        Eigen::ArrayXf xs_;
+        std::vector<int> gridCol_;
+        Eigen::ArrayXf gridColFrac_;
+        std::vector<int> gridRow_;
+        std::vector<float> gridRowFrac_;
+        RowMatrixXf buffer_;
+
+        template<class Source>
+        void run(const Source &source, int first, int count, std::uint64_t epoch, RowMatrixXf &out) const;
+    };
+};
+
+#endif //AUGMENT_HPP
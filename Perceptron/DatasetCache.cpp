@@ -0,0 +1,370 @@
+#include "DatasetCache.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MNIST_CACHE_MMAP
+#endif
+
+namespace IO_MNIST {
+    namespace {
+        constexpr char cacheMagic[8] = {'M', 'N', 'I', 'S', 'T', 'C', 'C', 'H'};
+        constexpr std::uint32_t cacheVersion = 1;
+
+        // First 128 bytes of a cache file, the data starts 64 byte aligned behind it.
+        struct CacheHeader {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t kind;
+            std::uint64_t sourceSize;
+            std::int64_t sourceMtime;
+            std::uint64_t sourceHash;
+            std::uint32_t count;
+            std::uint32_t rows;
+            std::uint32_t cols;
+            std::uint32_t reserved;
+            std::uint64_t dataOffset;
+            std::uint64_t oneHotOffset;
+            std::uint64_t totalSize;
+            char padding[48];
+        };
+        static_assert(sizeof(CacheHeader) == 128, "cache header has to stay 128 bytes");
+
+        std::uint64_t align64(const std::uint64_t offset) {
+            return (offset + 63) / 64 * 64;
+        }
+
+        std::uint64_t fnv1a(const char *data, const std::size_t size, std::uint64_t hash) {
+            for (std::size_t i = 0; i < size; ++i) {
+                hash ^= static_cast<unsigned char>(data[i]);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        std::uint32_t readBigEndian(const std::vector<unsigned char> &bytes, const std::size_t offset) {
+            return static_cast<std::uint32_t>(bytes[offset]) << 24 | static_cast<std::uint32_t>(bytes[offset + 1]) << 16
+                   | static_cast<std::uint32_t>(bytes[offset + 2]) << 8 | static_cast<std::uint32_t>(bytes[offset + 3]);
+        }
+
+        bool headerMatches(const CacheHeader &header, const SourceFingerprint &source, const char kind,
+                           const std::uint64_t fileSize) {
+            return std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0 && header.version == cacheVersion
+                   && header.kind == static_cast<std::uint32_t>(kind) && header.sourceSize == source.size
+                   && header.sourceMtime == source.mtime && header.sourceHash == source.hash
+                   && header.totalSize == fileSize;
+        }
+
+        // Parses the IDX file once and lays out the complete cache file in memory.
+        std::vector<char> buildCache(const std::string &idxPath, const char kind, const SourceFingerprint &source) {
+            std::ifstream file(idxPath, std::ios::binary);
+            if (!file.is_open()) {
+                throw std::runtime_error("Cannot open file: " + idxPath);
+            }
+            const std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            const std::size_t headerSize = kind == 'I' ? 16 : 8;
+            if (bytes.size() < headerSize) {
+                throw std::runtime_error("Truncated IDX file: " + idxPath);
+            }
+            const std::uint32_t magic = readBigEndian(bytes, 0);
+            const std::uint32_t count = readBigEndian(bytes, 4);
+            const std::uint32_t rows = kind == 'I' ? readBigEndian(bytes, 8) : 1;
+            const std::uint32_t cols = kind == 'I' ? readBigEndian(bytes, 12) : 1;
+            if (magic != (kind == 'I' ? 2051u : 2049u)) {
+                throw std::runtime_error("Unexpected magic number in " + idxPath);
+            }
+            const std::uint64_t entries = static_cast<std::uint64_t>(count) * rows * cols;
+            if (bytes.size() < headerSize + entries) {
+                throw std::runtime_error("Truncated IDX file: " + idxPath);
+            }
+
+            CacheHeader header{};
+            std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+            header.version = cacheVersion;
+            header.kind = static_cast<std::uint32_t>(kind);
+            header.sourceSize = source.size;
+            header.sourceMtime = source.mtime;
+            header.sourceHash = source.hash;
+            header.count = count;
+            header.rows = rows;
+            header.cols = cols;
+            header.dataOffset = sizeof(CacheHeader);
+            if (kind == 'I') {
+                header.totalSize = header.dataOffset + entries * sizeof(float);
+            } else {
+                header.oneHotOffset = align64(header.dataOffset + count * sizeof(std::int32_t));
+                header.totalSize = header.oneHotOffset + static_cast<std::uint64_t>(count) * 10 * sizeof(float);
+            }
+
+            std::vector<char> cache(header.totalSize, 0);
+            std::memcpy(cache.data(), &header, sizeof(header));
+            const unsigned char *raw = bytes.data() + headerSize;
+            if (kind == 'I') {
+                auto *pixels = reinterpret_cast<float *>(cache.data() + header.dataOffset);
+                for (std::uint64_t i = 0; i < entries; ++i) {
+                    pixels[i] = static_cast<float>(raw[i] / 255.0);
+                }
+            } else {
+                auto *labels = reinterpret_cast<std::int32_t *>(cache.data() + header.dataOffset);
+                auto *oneHot = reinterpret_cast<float *>(cache.data() + header.oneHotOffset);
+                for (std::uint32_t i = 0; i < count; ++i) {
+                    if (raw[i] > 9) {
+                        throw std::runtime_error("Label out of range in " + idxPath);
+                    }
+                    labels[i] = raw[i];
+                    oneHot[static_cast<std::size_t>(i) * 10 + raw[i]] = 1.0f;
+                }
+            }
+            return cache;
+        }
+
+        // Unused name next to path for a temporary file, created empty so no other writer gets it.
+        std::string uniqueTemporary(const std::string &path) {
+#ifdef MNIST_CACHE_MMAP
+            std::string tmp = path + ".tmp.XXXXXX";
+            const int fd = mkstemp(tmp.data());
+            if (fd < 0) {
+                return {};
+            }
+            // mkstemp creates the file 0600, the cache is as readable as any other output
+            fchmod(fd, 0644);
+            close(fd);
+            return tmp;
+#else
+            const auto thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+            const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+            return path + ".tmp." + std::to_string(thread) + "." + std::to_string(now);
+#endif
+        }
+
+        // Writes to a temporary file of its own first, so readers never see a half written cache
+        // and jobs building the same cache at once do not write into each other's file.
+        bool writeAtomically(const std::string &path, const std::vector<char> &data) {
+            const std::string tmp = uniqueTemporary(path);
+            if (tmp.empty()) {
+                return false;
+            }
+            {
+                std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+                if (!file.is_open()) {
+                    std::remove(tmp.c_str());
+                    return false;
+                }
+                file.write(data.data(), static_cast<std::streamsize>(data.size()));
+                if (!file.good()) {
+                    file.close();
+                    std::remove(tmp.c_str());
+                    return false;
+                }
+            }
+            std::error_code error;
+            std::filesystem::rename(tmp, path, error);
+            if (error) {
+                std::remove(tmp.c_str());
+                return false;
+            }
+            return true;
+        }
+    }
+
+    SourceFingerprint fingerprintFile(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        SourceFingerprint fingerprint;
+        fingerprint.size = std::filesystem::file_size(path);
+        fingerprint.mtime = static_cast<std::int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+
+        // header, 16 evenly spaced blocks and the tail; small files are hashed completely
+        constexpr std::uint64_t block = 4096;
+        std::vector<std::uint64_t> offsets;
+        if (fingerprint.size <= 64 * block) {
+            for (std::uint64_t offset = 0; offset < fingerprint.size; offset += block) {
+                offsets.push_back(offset);
+            }
+        } else {
+            for (std::uint64_t i = 0; i <= 16; ++i) {
+                offsets.push_back((fingerprint.size - block) * i / 16);
+            }
+        }
+        std::uint64_t hash = fnv1a(reinterpret_cast<const char *>(&fingerprint.size), sizeof(fingerprint.size),
+                                   14695981039346656037ull);
+        std::vector<char> buffer(block);
+        for (const std::uint64_t offset: offsets) {
+            file.seekg(static_cast<std::streamoff>(offset));
+            file.read(buffer.data(), static_cast<std::streamsize>(block));
+            hash = fnv1a(buffer.data(), static_cast<std::size_t>(file.gcount()), hash);
+            file.clear();
+        }
+        fingerprint.hash = hash;
+        return fingerprint;
+    }
+
+    /////////////////////////////////////////////
+    ///////////////////////////////////////////// MnistCache
+    /////////////////////////////////////////////
+
+    MnistCache MnistCache::open(const std::string &idxPath, const char ImageOrLabel, const std::string &cachePath) {
+        if (ImageOrLabel != 'I' && ImageOrLabel != 'L') {
+            throw std::invalid_argument("Expected I for images or L for labels");
+        }
+        const std::string path = cachePath.empty() ? idxPath + ".cache" : cachePath;
+        const SourceFingerprint source = fingerprintFile(idxPath);
+
+        MnistCache cache;
+        auto adopt = [&](const char *base) {
+            CacheHeader header{};
+            std::memcpy(&header, base, sizeof(header));
+            cache.base_ = base;
+            cache.kind_ = ImageOrLabel;
+            cache.count_ = static_cast<int>(header.count);
+            cache.rows_ = static_cast<int>(header.rows);
+            cache.cols_ = static_cast<int>(header.cols);
+            cache.dataOffset_ = header.dataOffset;
+            cache.oneHotOffset_ = header.oneHotOffset;
+        };
+
+        // fast path: a valid cache file only costs the fingerprint and one mapping
+#ifdef MNIST_CACHE_MMAP
+        if (const int fd = ::open(path.c_str(), O_RDONLY); fd >= 0) {
+            struct stat info{};
+            if (fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(CacheHeader)) {
+                void *map = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+                if (map != MAP_FAILED) {
+                    CacheHeader header{};
+                    std::memcpy(&header, map, sizeof(header));
+                    if (headerMatches(header, source, ImageOrLabel, static_cast<std::uint64_t>(info.st_size))) {
+                        ::close(fd);
+                        cache.map_ = map;
+                        cache.mapSize_ = static_cast<std::size_t>(info.st_size);
+                        adopt(static_cast<const char *>(map));
+                        return cache;
+                    }
+                    munmap(map, static_cast<std::size_t>(info.st_size));
+                }
+            }
+            ::close(fd);
+        }
+#else
+        if (std::ifstream file(path, std::ios::binary); file.is_open()) {
+            std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            CacheHeader header{};
+            if (data.size() >= sizeof(header)) {
+                std::memcpy(&header, data.data(), sizeof(header));
+                if (headerMatches(header, source, ImageOrLabel, data.size())) {
+                    cache.owned_ = std::move(data);
+                    adopt(cache.owned_.data());
+                    return cache;
+                }
+            }
+        }
+#endif
+
+        // missing, stale or corrupt: rebuild, and serve from memory if it cannot be stored
+        std::vector<char> data = buildCache(idxPath, ImageOrLabel, source);
+        if (writeAtomically(path, data)) {
+            MnistCache reopened = open(idxPath, ImageOrLabel, path);
+            if (reopened.mapped()) {
+                reopened.rebuilt_ = true;
+                return reopened;
+            }
+        }
+        cache.owned_ = std::move(data);
+        adopt(cache.owned_.data());
+        cache.rebuilt_ = true;
+        return cache;
+    }
+
+    MnistCache::MnistCache(MnistCache &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    MnistCache &MnistCache::operator=(MnistCache &&other) noexcept {
+        if (this != &other) {
+            release();
+            map_ = other.map_;
+            mapSize_ = other.mapSize_;
+            owned_ = std::move(other.owned_);
+            base_ = map_ != nullptr ? other.base_ : owned_.data();
+            kind_ = other.kind_;
+            count_ = other.count_;
+            rows_ = other.rows_;
+            cols_ = other.cols_;
+            dataOffset_ = other.dataOffset_;
+            oneHotOffset_ = other.oneHotOffset_;
+            rebuilt_ = other.rebuilt_;
+            other.map_ = nullptr;
+            other.base_ = nullptr;
+            other.count_ = 0;
+        }
+        return *this;
+    }
+
+    MnistCache::~MnistCache() {
+        release();
+    }
+
+    void MnistCache::release() {
+#ifdef MNIST_CACHE_MMAP
+        if (map_ != nullptr) {
+            munmap(map_, mapSize_);
+        }
+#endif
+        map_ = nullptr;
+        base_ = nullptr;
+    }
+
+    ImageMap MnistCache::images() const {
+        if (kind_ != 'I') {
+            throw std::logic_error("Not an images cache");
+        }
+        return {reinterpret_cast<const float *>(base_ + dataOffset_), count_, rows_ * cols_};
+    }
+
+    Eigen::Map<const Eigen::VectorXi> MnistCache::labels() const {
+        if (kind_ != 'L') {
+            throw std::logic_error("Not a labels cache");
+        }
+        return {reinterpret_cast<const int *>(base_ + dataOffset_), count_};
+    }
+
+    ImageMap MnistCache::oneHot() const {
+        if (kind_ != 'L') {
+            throw std::logic_error("Not a labels cache");
+        }
+        return {reinterpret_cast<const float *>(base_ + oneHotOffset_), count_, 10};
+    }
+
+    Eigen::MatrixXd MnistCache::imagesAsDouble(const int first, const int n) const {
+        if (first < 0 || n < 0 || first + n > count_) {
+            throw std::out_of_range("Image index out of range");
+        }
+        const ImageMap pixels = images();
+        Eigen::MatrixXd result(n, rows_ * cols_);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < rows_ * cols_; ++j) {
+                // back to the byte value, so the result is bit identical to loadMnistImages
+                result(i, j) = static_cast<double>(std::lround(pixels(first + i, j) * 255.0f)) / 255.0;
+            }
+        }
+        return result;
+    }
+
+    Eigen::MatrixXd MnistCache::oneHotAsDouble(const int first, const int n) const {
+        if (first < 0 || n < 0 || first + n > count_) {
+            throw std::out_of_range("Label index out of range");
+        }
+        return oneHot().middleRows(first, n).cast<double>();
+    }
+}
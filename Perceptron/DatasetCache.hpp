@@ -0,0 +1,85 @@
+#ifndef DATASET_CACHE_HPP
+#define DATASET_CACHE_HPP
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace IO_MNIST {
+    using ImageMap = Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>;
+
+    // Identifies the contents of an IDX file: size, modification time and a hash of the
+    // header and of evenly spaced blocks, so validating it does not read the whole file.
+    struct SourceFingerprint {
+        std::uint64_t size = 0;
+        std::int64_t mtime = 0;
+        std::uint64_t hash = 0;
+
+        bool operator==(const SourceFingerprint &) const = default;
+    };
+
+    SourceFingerprint fingerprintFile(const std::string &path);
+
+    // Preprocessed copy of an IDX images or labels file.
+    // The first open parses the IDX file once and writes normalised float images, or int labels
+    // plus one-hot rows, into an aligned binary cache file. Later opens only check the source
+    // fingerprint and mmap the cache. If the cache cannot be written the data is kept in memory.
+    class MnistCache {
+    public:
+        // ImageOrLabel is 'I' or 'L' like for readMnistHeader, cachePath defaults to <idxPath>.cache
+        static MnistCache open(const std::string &idxPath, char ImageOrLabel, const std::string &cachePath = "");
+
+        MnistCache(MnistCache &&other) noexcept;
+
+        MnistCache &operator=(MnistCache &&other) noexcept;
+
+        MnistCache(const MnistCache &) = delete;
+
+        MnistCache &operator=(const MnistCache &) = delete;
+
+        ~MnistCache();
+
+        [[nodiscard]] int count() const { return count_; }
+        [[nodiscard]] int rows() const { return rows_; }
+        [[nodiscard]] int cols() const { return cols_; }
+
+        // true if open() had to (re)build the cache from the IDX file
+        [[nodiscard]] bool rebuilt() const { return rebuilt_; }
+
+        // true if the data is served from a mapping of the cache file
+        [[nodiscard]] bool mapped() const { return map_ != nullptr; }
+
+        // count x rows*cols, pixels in [0, 1]; images caches only
+        [[nodiscard]] ImageMap images() const;
+
+        // labels caches only
+        [[nodiscard]] Eigen::Map<const Eigen::VectorXi> labels() const;
+        [[nodiscard]] ImageMap oneHot() const;
+
+        // Same values and layout as loadMnistImages / loadMnistLabels for entries [first, first + n).
+        [[nodiscard]] Eigen::MatrixXd imagesAsDouble(int first, int n) const;
+        [[nodiscard]] Eigen::MatrixXd oneHotAsDouble(int first, int n) const;
+
+    private:
+        MnistCache() = default;
+
+        const char *base_ = nullptr;
+        void *map_ = nullptr;
+        std::size_t mapSize_ = 0;
+        std::vector<char> owned_;
+        char kind_ = 0;
+        int count_ = 0;
+        int rows_ = 0;
+        int cols_ = 0;
+        std::uint64_t dataOffset_ = 0;
+        std::uint64_t oneHotOffset_ = 0;
+        bool rebuilt_ = false;
+
+        void release();
+    };
+};
+
+#endif //DATASET_CACHE_HPP
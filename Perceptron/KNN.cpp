@@ -0,0 +1,283 @@
+#include "KNN.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace KNN_MNIST {
+    namespace {
+        // Sorted list of the k smallest distances seen so far.
+        struct TopK {
+            std::vector<float> dist;
+            std::vector<int> idx;
+
+            explicit TopK(const int k) : dist(k, std::numeric_limits<float>::infinity()), idx(k, -1) {
+            }
+
+            void push(const float d, const int i) {
+                if (d >= dist.back()) {
+                    return;
+                }
+                size_t p = dist.size() - 1;
+                for (; p > 0 && dist[p - 1] > d; --p) {
+                    dist[p] = dist[p - 1];
+                    idx[p] = idx[p - 1];
+                }
+                dist[p] = d;
+                idx[p] = i;
+            }
+
+            void store(Neighbours &out, const int row) const {
+                for (size_t j = 0; j < dist.size(); ++j) {
+                    out.indices(row, static_cast<int>(j)) = idx[j];
+                    out.distances(row, static_cast<int>(j)) = std::max(0.0f, dist[j]);
+                }
+            }
+        };
+
+        // Calls fn(begin, end) for batches of rows, batches are pulled by numThreads threads.
+        template<class Function>
+        void forEachBatch(const int rows, const int batch, int numThreads, Function fn) {
+            if (numThreads <= 0) {
+                numThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+            }
+            const int batches = (rows + batch - 1) / batch;
+            numThreads = std::max(1, std::min(numThreads, batches));
+
+            std::atomic<int> next{0};
+            auto worker = [&]() {
+                for (int b = next++; b < batches; b = next++) {
+                    fn(b * batch, std::min(rows, (b + 1) * batch));
+                }
+            };
+            std::vector<std::thread> pool;
+            for (int t = 1; t < numThreads; ++t) {
+                pool.emplace_back(worker);
+            }
+            worker();
+            for (auto &thread: pool) {
+                thread.join();
+            }
+        }
+
+        void checkQuery(const Eigen::MatrixXd &queries, const RowMatrixXf &points, const int k) {
+            if (queries.cols() != points.cols()) {
+                throw std::invalid_argument("Query dimension does not match the index");
+            }
+            if (k <= 0 || k > points.rows()) {
+                throw std::invalid_argument("k must be between 1 and the number of training images");
+            }
+        }
+    }
+
+    /////////////////////////////////////////////
+    ///////////////////////////////////////////// Exact search
+    /////////////////////////////////////////////
+
+    BruteForceIndex::BruteForceIndex(const Eigen::MatrixXd &images, const int blockSize) :
+        points_(images.cast<float>()),
+        norms_(points_.rowwise().squaredNorm()),
+        blockSize_(std::max(1, blockSize)) {
+    }
+
+    Neighbours BruteForceIndex::search(const Eigen::MatrixXd &queries, const int k, const int numThreads) const {
+        checkQuery(queries, points_, k);
+        const int numQueries = static_cast<int>(queries.rows());
+        Neighbours result{Eigen::MatrixXi(numQueries, k), Eigen::MatrixXf(numQueries, k)};
+
+        // every block of training images is read once per batch of 256 queries, the distance tile
+        // is 256 x blockSize floats (4 MiB at the default) and is scanned right after its GEMM
+        forEachBatch(numQueries, 256, numThreads, [&](const int begin, const int end) {
+            const RowMatrixXf q = queries.middleRows(begin, end - begin).cast<float>();
+            const Eigen::VectorXf qNorms = q.rowwise().squaredNorm();
+            std::vector<TopK> best(end - begin, TopK(k));
+            RowMatrixXf dots;
+
+            for (int start = 0; start < size(); start += blockSize_) {
+                const int len = std::min(blockSize_, size() - start);
+                dots.noalias() = q * points_.middleRows(start, len).transpose();
+                for (int i = 0; i < end - begin; ++i) {
+                    const float *row = dots.data() + static_cast<size_t>(i) * len;
+                    for (int j = 0; j < len; ++j) {
+                        best[i].push(qNorms(i) + norms_(start + j) - 2.0f * row[j], start + j);
+                    }
+                }
+            }
+            for (int i = 0; i < end - begin; ++i) {
+                best[i].store(result, begin + i);
+            }
+        });
+        return result;
+    }
+
+    /////////////////////////////////////////////
+    ///////////////////////////////////////////// Inverted file index
+    /////////////////////////////////////////////
+
+    IVFIndex::IVFIndex(const Eigen::MatrixXd &images, int numLists, const int iterations, const unsigned seed) {
+        const RowMatrixXf data = images.cast<float>();
+        const int n = static_cast<int>(data.rows());
+        if (n == 0) {
+            throw std::invalid_argument("Cannot build an index without images");
+        }
+        numLists = std::clamp(numLists, 1, n);
+        std::mt19937 rng(seed);
+
+        // nearest centroid via argmin ||c||^2 - 2 x.c, one GEMM per block of images
+        auto assign = [&](const RowMatrixXf &points, std::vector<int> &assignment) {
+            centroidNorms_ = centroids_.rowwise().squaredNorm();
+            assignment.resize(points.rows());
+            forEachBatch(static_cast<int>(points.rows()), 2048, 0, [&](const int begin, const int end) {
+                const RowMatrixXf dots = points.middleRows(begin, end - begin) * centroids_.transpose();
+                for (int i = 0; i < end - begin; ++i) {
+                    Eigen::Index c;
+                    (centroidNorms_.transpose() - 2.0f * dots.row(i)).minCoeff(&c);
+                    assignment[begin + i] = static_cast<int>(c);
+                }
+            });
+        };
+
+        // k-means on a sample, the cells only need to be roughly balanced
+        std::vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+        const int sampleSize = std::min(n, 64 * numLists);
+        RowMatrixXf sample(sampleSize, data.cols());
+        for (int i = 0; i < sampleSize; ++i) {
+            sample.row(i) = data.row(order[i]);
+        }
+        centroids_ = sample.topRows(numLists);
+
+        std::vector<int> assignment;
+        for (int it = 0; it < iterations; ++it) {
+            assign(sample, assignment);
+            RowMatrixXf sums = RowMatrixXf::Zero(numLists, data.cols());
+            std::vector<int> counts(numLists, 0);
+            for (int i = 0; i < sampleSize; ++i) {
+                sums.row(assignment[i]) += sample.row(i);
+                ++counts[assignment[i]];
+            }
+            for (int c = 0; c < numLists; ++c) {
+                if (counts[c] > 0) {
+                    centroids_.row(c) = sums.row(c) / static_cast<float>(counts[c]);
+                } else {
+                    // reseed empty cells with a random image
+                    centroids_.row(c) = sample.row(static_cast<int>(rng() % sampleSize));
+                }
+            }
+        }
+
+        // counting sort of all images into their cells
+        assign(data, assignment);
+        listOffsets_.assign(numLists + 1, 0);
+        for (const int c: assignment) {
+            ++listOffsets_[c + 1];
+        }
+        std::partial_sum(listOffsets_.begin(), listOffsets_.end(), listOffsets_.begin());
+        std::vector<int> fill(listOffsets_.begin(), listOffsets_.end() - 1);
+        ids_.resize(n);
+        points_.resize(n, data.cols());
+        for (int i = 0; i < n; ++i) {
+            const int pos = fill[assignment[i]]++;
+            ids_[pos] = i;
+            points_.row(pos) = data.row(i);
+        }
+        norms_ = points_.rowwise().squaredNorm();
+    }
+
+    Neighbours IVFIndex::search(const Eigen::MatrixXd &queries, const int k, int numProbes, const int numThreads) const {
+        checkQuery(queries, points_, k);
+        numProbes = std::clamp(numProbes, 1, numLists());
+        const int numQueries = static_cast<int>(queries.rows());
+        Neighbours result{Eigen::MatrixXi(numQueries, k), Eigen::MatrixXf(numQueries, k)};
+
+        forEachBatch(numQueries, 64, numThreads, [&](const int begin, const int end) {
+            const RowMatrixXf q = queries.middleRows(begin, end - begin).cast<float>();
+            const Eigen::VectorXf qNorms = q.rowwise().squaredNorm();
+            const RowMatrixXf centroidDots = q * centroids_.transpose();
+            std::vector<int> lists(numLists());
+            Eigen::VectorXf dots;
+
+            for (int i = 0; i < end - begin; ++i) {
+                const Eigen::VectorXf scores = centroidNorms_.transpose() - 2.0f * centroidDots.row(i);
+                std::iota(lists.begin(), lists.end(), 0);
+                std::partial_sort(lists.begin(), lists.begin() + numProbes, lists.end(),
+                                  [&](const int a, const int b) { return scores(a) < scores(b); });
+
+                TopK best(k);
+                // lists beyond numProbes are only scanned while fewer than k images were seen,
+                // k <= size() so every query ends up with k real neighbours
+                int scanned = 0;
+                for (int p = 0; p < numLists() && (p < numProbes || scanned < k); ++p) {
+                    if (p == numProbes) {
+                        std::sort(lists.begin() + numProbes, lists.end(),
+                                  [&](const int a, const int b) { return scores(a) < scores(b); });
+                    }
+                    const int offset = listOffsets_[lists[p]];
+                    const int len = listOffsets_[lists[p] + 1] - offset;
+                    if (len == 0) {
+                        continue;
+                    }
+                    scanned += len;
+                    dots.noalias() = points_.middleRows(offset, len) * q.row(i).transpose();
+                    for (int j = 0; j < len; ++j) {
+                        best.push(qNorms(i) + norms_(offset + j) - 2.0f * dots(j), ids_[offset + j]);
+                    }
+                }
+                best.store(result, begin + i);
+            }
+        });
+        return result;
+    }
+
+    /////////////////////////////////////////////
+    ///////////////////////////////////////////// Evaluation
+    /////////////////////////////////////////////
+
+    Eigen::VectorXi labelsFromOneHot(const Eigen::MatrixXd &oneHot) {
+        Eigen::VectorXi labels(oneHot.rows());
+        for (int i = 0; i < oneHot.rows(); ++i) {
+            oneHot.row(i).maxCoeff(&labels(i));
+        }
+        return labels;
+    }
+
+    Eigen::VectorXi classify(const Neighbours &neighbours, const Eigen::VectorXi &trainLabels, const int numClasses) {
+        Eigen::VectorXi predicted(neighbours.indices.rows());
+        std::vector<int> votes(numClasses);
+        for (int i = 0; i < neighbours.indices.rows(); ++i) {
+            std::fill(votes.begin(), votes.end(), 0);
+            int best = 0;
+            for (int j = 0; j < neighbours.indices.cols(); ++j) {
+                const int idx = neighbours.indices(i, j);
+                if (idx < 0) {
+                    continue;
+                }
+                const int label = trainLabels(idx);
+                if (++votes[label] > votes[best]) {
+                    best = label;
+                }
+            }
+            predicted(i) = best;
+        }
+        return predicted;
+    }
+
+    double recall(const Neighbours &approx, const Neighbours &exact) {
+        if (approx.indices.rows() != exact.indices.rows() || exact.indices.size() == 0) {
+            throw std::invalid_argument("Neighbour lists do not match");
+        }
+        size_t found = 0;
+        for (int i = 0; i < exact.indices.rows(); ++i) {
+            for (int j = 0; j < exact.indices.cols(); ++j) {
+                const auto row = approx.indices.row(i);
+                found += std::find(row.begin(), row.end(), exact.indices(i, j)) != row.end();
+            }
+        }
+        return static_cast<double>(found) / static_cast<double>(exact.indices.size());
+    }
+}
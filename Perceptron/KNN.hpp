@@ -0,0 +1,68 @@
+#ifndef KNN_HPP
+#define KNN_HPP
+
+#pragma once
+
+#include <vector>
+#include <Eigen/Dense>
+
+namespace KNN_MNIST {
+    using RowMatrixXf = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    // k nearest training images per query, nearest first. distances are squared L2.
+    struct Neighbours {
+        Eigen::MatrixXi indices;
+        Eigen::MatrixXf distances;
+    };
+
+    // Exact search. Distances come from ||q||^2 - 2 q.x + ||x||^2, so the bulk of the work is
+    // one float GEMM per block of training images and query batch.
+    class BruteForceIndex {
+    public:
+        explicit BruteForceIndex(const Eigen::MatrixXd &images, int blockSize = 4096);
+
+        // numThreads = 0 uses all hardware threads, each thread handles its own query batches
+        Neighbours search(const Eigen::MatrixXd &queries, int k, int numThreads = 0) const;
+
+        [[nodiscard]] int size() const { return static_cast<int>(points_.rows()); }
+
+    private:
+        RowMatrixXf points_;
+        Eigen::VectorXf norms_;
+        int blockSize_;
+    };
+
+    // Approximate search with an inverted file: k-means partitions the training images into
+    // numLists cells, a query only scans the numProbes cells with the closest centroids. If those
+    // hold fewer than k images the next closest cells are scanned too, so every row of the result
+    // has k valid indices.
+    class IVFIndex {
+    public:
+        explicit IVFIndex(const Eigen::MatrixXd &images, int numLists = 256, int iterations = 10,
+                          unsigned seed = 42);
+
+        Neighbours search(const Eigen::MatrixXd &queries, int k, int numProbes = 8, int numThreads = 0) const;
+
+        [[nodiscard]] int numLists() const { return static_cast<int>(centroids_.rows()); }
+
+    private:
+        RowMatrixXf centroids_;
+        Eigen::VectorXf centroidNorms_;
+        // training images reordered so every list is a contiguous block of rows
+        RowMatrixXf points_;
+        Eigen::VectorXf norms_;
+        std::vector<int> ids_;
+        std::vector<int> listOffsets_;
+    };
+
+    // Class indices from one-hot rows as returned by IO_MNIST::loadMnistLabels.
+    Eigen::VectorXi labelsFromOneHot(const Eigen::MatrixXd &oneHot);
+
+    // Majority vote of the neighbours, ties go to the class that reached the count first.
+    Eigen::VectorXi classify(const Neighbours &neighbours, const Eigen::VectorXi &trainLabels, int numClasses = 10);
+
+    // Fraction of the exact neighbours that were also found by the approximate search.
+    double recall(const Neighbours &approx, const Neighbours &exact);
+};
+
+#endif //KNN_HPP
@@ -0,0 +1,71 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include "Augment.hpp"
+#include "DatasetCache.hpp"
+
+// Throughput of the augmentation stage over a whole MNIST split in training batches,
+// against copying the same batches unaugmented (what a training step reads today).
+// Usage: augment_benchmark <images_idx> [batch_size] [epochs]
+
+namespace {
+    template<class Function>
+    double seconds(Function fn) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " <images_idx> [batch_size] [epochs]" << std::endl;
+        return -1;
+    }
+    const std::string imagePath = argv[1];
+    const int batchSize = argc > 2 ? std::stoi(argv[2]) : 128;
+    const int epochs = argc > 3 ? std::stoi(argv[3]) : 3;
+
+    try {
+        const auto cache = IO_MNIST::MnistCache::open(imagePath, 'I');
+        const auto images = cache.images();
+        const int count = cache.count();
+        const double total = static_cast<double>(count) * epochs;
+        AUGMENT_MNIST::RowMatrixXf batch;
+
+        const double copy = seconds([&] {
+            for (int epoch = 0; epoch < epochs; ++epoch) {
+                for (int first = 0; first < count; first += batchSize) {
+                    batch = images.middleRows(first, std::min(batchSize, count - first));
+                }
+            }
+        });
+        std::cout << count << " images of " << cache.rows() << "x" << cache.cols() << ", batches of " << batchSize
+                << ", " << epochs << " epochs\n"
+                << "unaugmented copy: " << total / copy << " images/s\n";
+
+        const int hardware = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<int> threadCounts;
+        for (int threads = 1; threads < hardware; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(hardware);
+        for (const int threads: threadCounts) {
+            const AUGMENT_MNIST::Augmenter augmenter(cache.rows(), cache.cols(), {}, threads);
+            const double time = seconds([&] {
+                for (int epoch = 0; epoch < epochs; ++epoch) {
+                    for (int first = 0; first < count; first += batchSize) {
+                        augmenter.augment(images, first, std::min(batchSize, count - first), epoch, batch);
+                    }
+                }
+            });
+            std::cout << "augmented, " << threads << " thread(s): " << total / time << " images/s, "
+                    << total / time / threads << " images/s per core, "
+                    << time / (total / batchSize) * 1e6 << " us per batch" << std::endl;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
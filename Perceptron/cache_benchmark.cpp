@@ -0,0 +1,83 @@
+#include <chrono>
+#include <iostream>
+#include "IO.hpp"
+#include "DatasetCache.hpp"
+
+// Startup time to get a whole MNIST split into memory: parsing the IDX files with
+// loadMnistImages / loadMnistLabels against opening the preprocessed caches (cold builds them,
+// warm only checks the fingerprints and maps them).
+// Usage: cache_benchmark <images_idx> <labels_idx> [repetitions]
+
+namespace {
+    template<class Function>
+    double bestSeconds(const int reps, Function fn) {
+        double best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: " << argv[0] << " <images_idx> <labels_idx> [repetitions]" << std::endl;
+        return -1;
+    }
+    const std::string imagePath = argv[1];
+    const std::string labelPath = argv[2];
+    const int reps = argc > 3 ? std::stoi(argv[3]) : 5;
+    const std::string imageCachePath = "cache_benchmark_images.cache";
+    const std::string labelCachePath = "cache_benchmark_labels.cache";
+
+    try {
+        int magic, numImages, numLabels, rows, cols, unused;
+        IO_MNIST::readMnistHeader(imagePath, magic, numImages, rows, cols, 'I');
+        IO_MNIST::readMnistHeader(labelPath, magic, numLabels, unused, unused, 'L');
+
+        // read one value of each so nothing is optimised away
+        volatile double sink = 0;
+        const double parse = bestSeconds(reps, [&] {
+            const auto images = IO_MNIST::loadMnistImages(imagePath, numImages, rows, cols);
+            const auto labels = IO_MNIST::loadMnistLabels(labelPath, numLabels);
+            sink = images(numImages - 1, 0) + labels(numLabels - 1, 0);
+        });
+
+        const double cold = bestSeconds(reps, [&] {
+            std::remove(imageCachePath.c_str());
+            std::remove(labelCachePath.c_str());
+            const auto images = IO_MNIST::MnistCache::open(imagePath, 'I', imageCachePath);
+            const auto labels = IO_MNIST::MnistCache::open(labelPath, 'L', labelCachePath);
+            sink = images.images()(numImages - 1, 0) + labels.oneHot()(numLabels - 1, 0);
+        });
+
+        bool mapped = true;
+        const double warm = bestSeconds(reps, [&] {
+            const auto images = IO_MNIST::MnistCache::open(imagePath, 'I', imageCachePath);
+            const auto labels = IO_MNIST::MnistCache::open(labelPath, 'L', labelCachePath);
+            mapped &= images.mapped() && labels.mapped() && !images.rebuilt() && !labels.rebuilt();
+            sink = images.images()(numImages - 1, 0) + labels.oneHot()(numLabels - 1, 0);
+        });
+
+        // first touch of every page of the mapped images, what a training epoch would pay on top
+        const double touch = bestSeconds(reps, [&] {
+            const auto images = IO_MNIST::MnistCache::open(imagePath, 'I', imageCachePath);
+            sink = images.images().sum();
+        });
+
+        std::cout << numImages << " images of " << rows << "x" << cols << ", best of " << reps << "\n"
+                << "parse IDX (double):      " << parse * 1e3 << " ms\n"
+                << "cache build (cold):      " << cold * 1e3 << " ms\n"
+                << "cache open (warm, mmap): " << warm * 1e3 << " ms" << (mapped ? "" : " (not mapped)") << "\n"
+                << "warm open + full scan:   " << touch * 1e3 << " ms\n"
+                << "startup speedup:         " << parse / warm << "x" << std::endl;
+        std::remove(imageCachePath.c_str());
+        std::remove(labelCachePath.c_str());
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <iostream>
+#include "IO.hpp"
+#include "KNN.hpp"
+
+using namespace IO_MNIST;
+using namespace KNN_MNIST;
+
+// k-NN baseline on MNIST: exact GEMM based search against the IVF index.
+// Usage: knn_benchmark [numQueries] [k] [numLists] [numProbes] [numThreads]
+// The dataset is read from ./dataset (or ../dataset when run from a build directory).
+
+namespace {
+    double secondsSince(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double accuracy(const Eigen::VectorXi &predicted, const Eigen::VectorXi &labels) {
+        return static_cast<double>((predicted.array() == labels.array()).count()) / static_cast<double>(labels.size());
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    const int numQueries = argc > 1 ? std::stoi(argv[1]) : 10000;
+    const int k = argc > 2 ? std::stoi(argv[2]) : 10;
+    const int numLists = argc > 3 ? std::stoi(argv[3]) : 256;
+    const int numProbes = argc > 4 ? std::stoi(argv[4]) : 8;
+    const int numThreads = argc > 5 ? std::stoi(argv[5]) : 0;
+
+    try {
+        const std::string dir = std::ifstream("./dataset/train-labels.idx1-ubyte").good() ? "./dataset/" : "../dataset/";
+        int magic, numTrain, numTest, rows, cols, unused;
+        readMnistHeader(dir + "train-images.idx3-ubyte", magic, numTrain, rows, cols, 'I');
+        readMnistHeader(dir + "t10k-images.idx3-ubyte", magic, numTest, rows, cols, 'I');
+        const int queries = std::min(numQueries, numTest);
+
+        const auto trainImages = loadMnistImages(dir + "train-images.idx3-ubyte", numTrain, rows, cols);
+        const auto testImages = loadMnistImages(dir + "t10k-images.idx3-ubyte", queries, rows, cols);
+        readMnistHeader(dir + "train-labels.idx1-ubyte", magic, numTrain, unused, unused, 'L');
+        const Eigen::VectorXi trainLabels = labelsFromOneHot(loadMnistLabels(dir + "train-labels.idx1-ubyte", numTrain));
+        const Eigen::VectorXi testLabels = labelsFromOneHot(loadMnistLabels(dir + "t10k-labels.idx1-ubyte", queries));
+
+        auto start = std::chrono::steady_clock::now();
+        const BruteForceIndex exact(trainImages);
+        const double exactBuild = secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        const Neighbours exactResult = exact.search(testImages, k, numThreads);
+        const double exactTime = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        const IVFIndex ivf(trainImages, numLists);
+        const double ivfBuild = secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        const Neighbours ivfResult = ivf.search(testImages, k, numProbes, numThreads);
+        const double ivfTime = secondsSince(start);
+
+        // latency of single queries, one thread
+        const int single = std::min(queries, 200);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < single; ++i) {
+            ivf.search(testImages.middleRows(i, 1), k, numProbes, 1);
+        }
+        const double ivfLatency = secondsSince(start) / single;
+
+        std::cout << numTrain << " training images, " << queries << " queries, k = " << k << "\n"
+                << "exact: build " << exactBuild << " s, " << queries / exactTime << " queries/s, accuracy "
+                << accuracy(classify(exactResult, trainLabels), testLabels) << "\n"
+                << "ivf (" << numLists << " lists, " << numProbes << " probes): build " << ivfBuild << " s, "
+                << queries / ivfTime << " queries/s, " << ivfLatency * 1e3 << " ms per single query, recall "
+                << recall(ivfResult, exactResult) << ", accuracy "
+                << accuracy(classify(ivfResult, trainLabels), testLabels) << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include "IO.hpp"
+#include "eigen_interop.hpp"
+
+// Time to get one MNIST image into the tensor world: through the text file written by
+// IO_MNIST::writeTensorToFile and read back by readTensorFromFile, against a zero-copy view
+// of the loaded Eigen matrix (and its copy into an owning Tensor).
+// Usage: load_benchmark <image_dataset_input> [image_index] [repetitions]
+
+namespace {
+    template<class Function>
+    double bestSeconds(const int reps, Function fn) {
+        double best = 1e300;
+        for (int r = 0; r < reps; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " <image_dataset_input> [image_index] [repetitions]" << std::endl;
+        return -1;
+    }
+    const std::string inputPath = argv[1];
+    const int index = argc > 2 ? std::stoi(argv[2]) : 0;
+    const int reps = argc > 3 ? std::stoi(argv[3]) : 20;
+    const std::string tensorFile = "load_benchmark_image";
+
+    try {
+        int magic, numImages, rows, cols;
+        IO_MNIST::readMnistHeader(inputPath, magic, numImages, rows, cols, 'I');
+        const auto r = static_cast<size_t>(rows);
+        const auto c = static_cast<size_t>(cols);
+
+        Eigen::MatrixXd images;
+        const double load = bestSeconds(reps, [&] {
+            images = IO_MNIST::loadMnistImages(inputPath, index + 1, rows, cols);
+        });
+
+        // reshaped(rows, cols) as in read_dataset fills column by column and writes the transpose,
+        // the transposed cols x rows reshape writes the image the way the view sees it at the same
+        // cost (reshaped<Eigen::RowMajor> of a strided row evaluates wrongly in Eigen 3.4.0)
+        Tensor<double> fromFile;
+        const double fileRoundTrip = bestSeconds(reps, [&] {
+            IO_MNIST::writeTensorToFile(images.row(index).reshaped(cols, rows).transpose(), tensorFile);
+            fromFile = readTensorFromFile<double>(tensorFile);
+        });
+
+        // read one pixel so the view is not optimised away
+        volatile double sink = 0;
+        const double view = bestSeconds(reps, [&] {
+            const auto image = rowAsTensorView(images, index, r, c);
+            sink = image({r / 2, c / 2});
+        });
+
+        Tensor<double> copied;
+        const double viewCopy = bestSeconds(reps, [&] {
+            copied = rowAsTensorView(images, index, r, c).toTensor();
+        });
+
+        std::remove(tensorFile.c_str());
+
+        // both paths have to produce the same image for the before/after comparison to hold, the
+        // text file keeps 6 significant digits of each pixel
+        bool same = fromFile.shape() == copied.shape();
+        for (size_t i = 0; same && i < r; ++i) {
+            for (size_t j = 0; j < c; ++j) {
+                same &= copied({i, j}) == images(index, static_cast<Eigen::Index>(i * c + j));
+                same &= std::abs(fromFile({i, j}) - copied({i, j})) <= 1e-6;
+            }
+        }
+
+        std::cout << "image " << index << " (" << rows << "x" << cols << "), best of " << reps << "\n"
+                << "loadMnistImages:         " << load * 1e6 << " us\n"
+                << "text file round trip:    " << fileRoundTrip * 1e6 << " us\n"
+                << "zero-copy TensorView:    " << view * 1e6 << " us\n"
+                << "TensorView -> Tensor:    " << viewCopy * 1e6 << " us\n"
+                // both paths end in an owning Tensor, the view alone is listed for code that can keep it
+                << "end to end before/after: " << (load + fileRoundTrip) * 1e6 << " us / " << (load + viewCopy) * 1e6
+                << " us\n"
+                << "end to end, view only:   " << (load + view) * 1e6 << " us\n"
+                << "pixels match: " << (same ? "yes" : "no") << std::endl;
+        return same ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
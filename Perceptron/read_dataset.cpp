@@ -2,6 +2,7 @@
 #include <iostream>
 #include <filesystem>
 #include "IO.hpp"
+#include "DatasetCache.hpp"
 
 using namespace IO_MNIST;
 
@@ -24,13 +25,15 @@ int main(const int argc, char *argv[]) {
             else {rows = 1; cols=10;}
 
             if (ImageOrLabel == 'I') {
-                // Load a couple of pictures after the required index
-                const auto dataset = loadMnistImages(inputPath, index + 1, rows, cols);
-                writeTensorToFile(dataset.row(index).reshaped(rows,cols),outputPath);
+                // Preprocessed once into <inputPath>.cache, later runs only map it
+                const auto cache = MnistCache::open(inputPath, 'I');
+                const auto image = cache.imagesAsDouble(index, 1);
+                writeTensorToFile(image.row(0).reshaped(rows,cols),outputPath);
 
             } else if (ImageOrLabel == 'L') {
-                const auto dataset = loadMnistLabels(inputPath, index + 1);
-                writeTensorToFile(dataset.row(index).reshaped(rows,cols),outputPath);
+                const auto cache = MnistCache::open(inputPath, 'L');
+                const auto label = cache.oneHotAsDouble(index, 1);
+                writeTensorToFile(label.row(0).reshaped(rows,cols),outputPath);
 
             }
             else {
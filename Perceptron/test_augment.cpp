@@ -0,0 +1,135 @@
+#include <iostream>
+#include "Augment.hpp"
+
+using namespace AUGMENT_MNIST;
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+// Blobs well inside the 28x28 frame, so small warps never push ink out of the image.
+RowMatrixXf makeImages(const int count) {
+    RowMatrixXf images = RowMatrixXf::Zero(count, 28 * 28);
+    for (int i = 0; i < count; ++i) {
+        for (int y = 9; y < 19; ++y) {
+            for (int x = 9 + i % 3; x < 17 + i % 3; ++x) {
+                images(i, y * 28 + x) = static_cast<float>((x * 13 + y * 7 + i) % 255) / 255.0f;
+            }
+        }
+    }
+    return images;
+}
+
+void test_identity(std::vector<std::pair<bool, std::string> > &results) {
+    const RowMatrixXf images = makeImages(20);
+    AugmentConfig none{0, 0, 0, 0, 0, 4, 0, 1};
+    const Augmenter augmenter(28, 28, none, 3);
+    RowMatrixXf out;
+    augmenter.augment(images, 0, 20, 0, out);
+    results.push_back({out == images, "test_identity: all ranges 0 copies the images"});
+
+    augmenter.augmentFromDouble(images.cast<double>(), 5, 10, 0, out);
+    results.push_back({out == images.middleRows(5, 10), "test_identity: double input"});
+}
+
+void test_determinism(std::vector<std::pair<bool, std::string> > &results) {
+    const RowMatrixXf images = makeImages(100);
+    const AugmentConfig config;
+    RowMatrixXf single, parallel, part, other;
+    Augmenter(28, 28, config, 1).augment(images, 0, 100, 3, single);
+    Augmenter(28, 28, config, 4).augment(images, 0, 100, 3, parallel);
+    results.push_back({single == parallel, "test_determinism: independent of the number of threads"});
+
+    Augmenter(28, 28, config, 2).augment(images, 37, 20, 3, part);
+    results.push_back({part == single.middleRows(37, 20), "test_determinism: independent of the batch boundaries"});
+
+    Augmenter(28, 28, config, 2).augment(images, 0, 100, 4, other);
+    results.push_back({other != single, "test_determinism: epochs differ"});
+    results.push_back({single.row(0) != single.row(3), "test_determinism: samples differ"});
+
+    AugmentConfig reseeded;
+    reseeded.seed = 7;
+    Augmenter(28, 28, reseeded, 1).augment(images, 0, 100, 3, other);
+    results.push_back({other != single, "test_determinism: seeds differ"});
+    results.push_back({single.minCoeff() >= 0.0f && single.maxCoeff() <= 1.0f, "test_determinism: values in [0, 1]"});
+}
+
+void test_warps(std::vector<std::pair<bool, std::string> > &results) {
+    const RowMatrixXf images = makeImages(50);
+    RowMatrixXf out;
+
+    // bilinear translations keep the ink, the centre of mass moves by at most the shift
+    AugmentConfig shift{3, 0, 0, 0, 0, 4, 0, 1};
+    Augmenter(28, 28, shift, 2).augment(images, 0, 50, 0, out);
+    bool kept = true;
+    bool bounded = true;
+    bool moved = false;
+    for (int i = 0; i < 50; ++i) {
+        double mass[2] = {0, 0}, mx[2] = {0, 0}, my[2] = {0, 0};
+        for (int j = 0; j < 2; ++j) {
+            const auto &m = j == 0 ? images : out;
+            for (int p = 0; p < 28 * 28; ++p) {
+                mass[j] += m(i, p);
+                mx[j] += m(i, p) * (p % 28);
+                my[j] += m(i, p) * (p / 28);
+            }
+        }
+        kept &= std::abs(mass[0] - mass[1]) < 1e-3;
+        const double ddx = mx[1] / mass[1] - mx[0] / mass[0];
+        const double ddy = my[1] / mass[1] - my[0] / mass[0];
+        bounded &= std::abs(ddx) <= 3.0 + 1e-3 && std::abs(ddy) <= 3.0 + 1e-3;
+        moved |= std::abs(ddx) > 0.5;
+    }
+    results.push_back({kept, "test_warps: shifts keep the ink"});
+    results.push_back({bounded && moved, "test_warps: shifts within range"});
+
+    // each transformation on its own changes the image
+    bool changed = true;
+    for (AugmentConfig single: {AugmentConfig{0, 0.3f, 0, 0, 0, 4, 0, 1}, AugmentConfig{0, 0, 0.2f, 0, 0, 4, 0, 1},
+                                AugmentConfig{0, 0, 0, 0.2f, 0, 4, 0, 1}, AugmentConfig{0, 0, 0, 0, 2.0f, 4, 0, 1},
+                                AugmentConfig{0, 0, 0, 0, 0, 4, 0.05f, 1}}) {
+        Augmenter(28, 28, single, 1).augment(images, 0, 50, 0, out);
+        changed &= (out - images).cwiseAbs().maxCoeff() > 1e-3f;
+    }
+    results.push_back({changed, "test_warps: rotation, scale, shear, elastic and noise"});
+
+    bool thrown = false;
+    try {
+        Augmenter(28, 28).augment(images, 45, 10, 0, out);
+    } catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_warps: batch out of range throws"});
+
+    thrown = false;
+    try {
+        Augmenter(14, 14).augment(images, 0, 10, 0, out);
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_warps: wrong image size throws"});
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+
+    test_identity(results);
+    test_determinism(results);
+    test_warps(results);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include "IO.hpp"
+#include "DatasetCache.hpp"
+
+using namespace IO_MNIST;
+
+namespace fs = std::filesystem;
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+void writeBigEndian(std::ofstream &file, const std::uint32_t value) {
+    const char bytes[4] = {static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+                           static_cast<char>(value >> 8), static_cast<char>(value)};
+    file.write(bytes, 4);
+}
+
+// Synthetic IDX files, large enough that the fingerprint only samples the images file.
+void writeDataset(const fs::path &images, const fs::path &labels, const int count, const int seed) {
+    std::ofstream imageFile(images, std::ios::binary);
+    writeBigEndian(imageFile, 2051);
+    writeBigEndian(imageFile, count);
+    writeBigEndian(imageFile, 28);
+    writeBigEndian(imageFile, 28);
+    for (int i = 0; i < count * 28 * 28; ++i) {
+        imageFile.put(static_cast<char>((i * 7 + seed) % 256));
+    }
+    std::ofstream labelFile(labels, std::ios::binary);
+    writeBigEndian(labelFile, 2049);
+    writeBigEndian(labelFile, count);
+    for (int i = 0; i < count; ++i) {
+        labelFile.put(static_cast<char>((i + seed) % 10));
+    }
+}
+
+void patchByte(const fs::path &path, const std::streamoff offset, const char value) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(offset);
+    file.put(value);
+}
+
+void test_values(const fs::path &dir, std::vector<std::pair<bool, std::string> > &results) {
+    const auto images = (dir / "images.idx3-ubyte").string();
+    const auto labels = (dir / "labels.idx1-ubyte").string();
+    writeDataset(images, labels, 400, 3);
+
+    const auto first = MnistCache::open(images, 'I');
+    results.push_back({first.rebuilt() && first.mapped() && fs::exists(images + ".cache"),
+                       "test_values: first open builds the cache"});
+    const auto imageCache = MnistCache::open(images, 'I');
+    const auto labelCache = MnistCache::open(labels, 'L');
+    results.push_back({!imageCache.rebuilt() && imageCache.mapped(), "test_values: second open maps the cache"});
+    results.push_back({imageCache.count() == 400 && imageCache.rows() == 28 && imageCache.cols() == 28,
+                       "test_values: header"});
+
+    results.push_back({imageCache.imagesAsDouble(0, 400) == loadMnistImages(images, 400, 28, 28),
+                       "test_values: images equal loadMnistImages"});
+    results.push_back({labelCache.oneHotAsDouble(0, 400) == loadMnistLabels(labels, 400),
+                       "test_values: one-hot equal loadMnistLabels"});
+    results.push_back({labelCache.labels()(13) == 6 && labelCache.oneHot()(13, 6) == 1.0f,
+                       "test_values: int labels"});
+    results.push_back({reinterpret_cast<std::uintptr_t>(imageCache.images().data()) % 64 == 0
+                       && reinterpret_cast<std::uintptr_t>(labelCache.oneHot().data()) % 64 == 0,
+                       "test_values: 64 byte aligned"});
+
+    bool thrown = false;
+    try {
+        static_cast<void>(imageCache.imagesAsDouble(399, 2));
+    } catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_values: out of range throws"});
+}
+
+void test_invalidation(const fs::path &dir, std::vector<std::pair<bool, std::string> > &results) {
+    const auto images = (dir / "images.idx3-ubyte").string();
+    const auto labels = (dir / "labels.idx1-ubyte").string();
+    writeDataset(images, labels, 400, 5);
+    static_cast<void>(MnistCache::open(images, 'I'));
+
+    // only the modification time changes
+    fs::last_write_time(images, fs::last_write_time(images) + std::chrono::seconds(10));
+    results.push_back({MnistCache::open(images, 'I').rebuilt(), "test_invalidation: mtime"});
+    results.push_back({!MnistCache::open(images, 'I').rebuilt(), "test_invalidation: valid after rebuild"});
+
+    // same size and mtime, different contents in a hashed block
+    const auto before = fingerprintFile(images);
+    const auto mtime = fs::last_write_time(images);
+    patchByte(images, 20, 42);
+    fs::last_write_time(images, mtime);
+    const auto after = fingerprintFile(images);
+    results.push_back({after.size == before.size && after.mtime == before.mtime && after.hash != before.hash,
+                       "test_invalidation: fingerprint hash only"});
+    auto patched = MnistCache::open(images, 'I');
+    results.push_back({patched.rebuilt() && patched.images()(0, 4) == static_cast<float>(42 / 255.0),
+                       "test_invalidation: content hash"});
+
+    // different size
+    writeDataset(images, labels, 401, 5);
+    auto grown = MnistCache::open(images, 'I');
+    results.push_back({grown.rebuilt() && grown.count() == 401, "test_invalidation: size"});
+
+    // truncated and corrupt cache files
+    fs::resize_file(images + ".cache", 1000);
+    results.push_back({MnistCache::open(images, 'I').rebuilt(), "test_invalidation: truncated cache"});
+    patchByte(images + ".cache", 0, 'X');
+    results.push_back({MnistCache::open(images, 'I').rebuilt(), "test_invalidation: corrupt magic"});
+
+    // a labels cache is not accepted for images
+    const auto labelCachePath = (dir / "shared.cache").string();
+    static_cast<void>(MnistCache::open(labels, 'L', labelCachePath));
+    fs::copy_file(labelCachePath, images + ".cache", fs::copy_options::overwrite_existing);
+    results.push_back({MnistCache::open(images, 'I').rebuilt(), "test_invalidation: wrong kind"});
+}
+
+void test_unwritable(const fs::path &dir, std::vector<std::pair<bool, std::string> > &results) {
+    const auto images = (dir / "images.idx3-ubyte").string();
+    const auto labels = (dir / "labels.idx1-ubyte").string();
+    writeDataset(images, labels, 20, 1);
+
+    const auto cache = MnistCache::open(images, 'I', (dir / "missing" / "images.cache").string());
+    results.push_back({cache.rebuilt() && !cache.mapped(), "test_unwritable: served from memory"});
+    results.push_back({cache.imagesAsDouble(0, 20) == loadMnistImages(images, 20, 28, 28),
+                       "test_unwritable: values"});
+
+    bool thrown = false;
+    try {
+        static_cast<void>(MnistCache::open((dir / "missing.idx3-ubyte").string(), 'I'));
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_unwritable: missing source throws"});
+}
+
+void test_concurrent(const fs::path &dir, std::vector<std::pair<bool, std::string> > &results) {
+    const auto images = (dir / "images.idx3-ubyte").string();
+    const auto labels = (dir / "labels.idx1-ubyte").string();
+    writeDataset(images, labels, 2000, 5);
+    fs::remove(images + ".cache");
+
+    // jobs starting together all build the cache, each has to end up with intact data
+    const Eigen::MatrixXd expected = loadMnistImages(images, 2000, 28, 28);
+    std::vector<char> intact(8, 0);
+    std::vector<std::thread> jobs;
+    for (size_t j = 0; j < intact.size(); ++j) {
+        jobs.emplace_back([&, j] {
+            intact[j] = MnistCache::open(images, 'I').imagesAsDouble(0, 2000) == expected;
+        });
+    }
+    for (auto &job: jobs) {
+        job.join();
+    }
+    results.push_back({std::all_of(intact.begin(), intact.end(), [](const char ok) { return ok != 0; }),
+                       "test_concurrent: every job reads intact images"});
+
+    const auto reopened = MnistCache::open(images, 'I');
+    results.push_back({!reopened.rebuilt() && reopened.imagesAsDouble(0, 2000) == expected,
+                       "test_concurrent: cache on disk is intact"});
+    bool leftover = false;
+    for (const auto &entry: fs::directory_iterator(dir)) {
+        leftover |= entry.path().string().find(".tmp") != std::string::npos;
+    }
+    results.push_back({!leftover, "test_concurrent: no temporary files left"});
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+    const fs::path dir = fs::temp_directory_path() / "test_dataset_cache";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    test_values(dir, results);
+    test_invalidation(dir, results);
+    test_unwritable(dir, results);
+    test_concurrent(dir, results);
+    fs::remove_all(dir);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include "KNN.hpp"
+
+using namespace KNN_MNIST;
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+// Small integer coordinates keep every squared distance exact in float, ties included.
+Eigen::MatrixXd makeGrid(const int rows, const int cols, const unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> value(0, 7);
+    Eigen::MatrixXd points(rows, cols);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            points(i, j) = value(rng);
+        }
+    }
+    return points;
+}
+
+// Continuous coordinates, ties between distances practically never happen.
+Eigen::MatrixXd makePoints(const int rows, const int cols, const unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> value(0.0, 1.0);
+    Eigen::MatrixXd points(rows, cols);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            points(i, j) = value(rng);
+        }
+    }
+    return points;
+}
+
+// Every distance computed directly, sorted by distance and then by index.
+Neighbours naiveSearch(const Eigen::MatrixXd &points, const Eigen::MatrixXd &queries, const int k) {
+    Neighbours result{Eigen::MatrixXi(queries.rows(), k), Eigen::MatrixXf(queries.rows(), k)};
+    std::vector<int> order(points.rows());
+    std::vector<double> dist(points.rows());
+    for (int i = 0; i < queries.rows(); ++i) {
+        for (int j = 0; j < points.rows(); ++j) {
+            dist[j] = (points.row(j) - queries.row(i)).squaredNorm();
+        }
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](const int a, const int b) { return dist[a] < dist[b]; });
+        for (int j = 0; j < k; ++j) {
+            result.indices(i, j) = order[j];
+            result.distances(i, j) = static_cast<float>(dist[order[j]]);
+        }
+    }
+    return result;
+}
+
+template<class Function>
+bool throwsInvalid(Function fn) {
+    try {
+        fn();
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+
+void test_brute_force(std::vector<std::pair<bool, std::string> > &results) {
+    // several training blocks and query batches, the last of each partial
+    const Eigen::MatrixXd points = makeGrid(300, 20, 1);
+    const Eigen::MatrixXd queries = makeGrid(300, 20, 2);
+    const auto expected = naiveSearch(points, queries, 7);
+    for (const int threads: {1, 3}) {
+        const auto found = BruteForceIndex(points, 64).search(queries, 7, threads);
+        results.push_back({found.indices == expected.indices && found.distances == expected.distances,
+                           "test_brute_force: equals the naive search, " + std::to_string(threads) + " thread(s)"});
+    }
+    const auto all = BruteForceIndex(points).search(queries.topRows(5), 300, 1);
+    results.push_back({all.indices == naiveSearch(points, queries.topRows(5), 300).indices,
+                       "test_brute_force: k = number of training images"});
+}
+
+void test_ivf(std::vector<std::pair<bool, std::string> > &results) {
+    const Eigen::MatrixXd points = makePoints(400, 16, 3);
+    const Eigen::MatrixXd queries = makePoints(50, 16, 4);
+    const auto exact = BruteForceIndex(points).search(queries, 5, 2);
+
+    const IVFIndex index(points, 12);
+    const auto all = index.search(queries, 5, index.numLists(), 2);
+    results.push_back({all.indices == exact.indices && all.distances.isApprox(exact.distances, 1e-4f),
+                       "test_ivf: probing every list is exact"});
+
+    // one image per list, a single probe has to continue into further lists to find k
+    const IVFIndex tiny(points.topRows(40), 40);
+    const auto sparse = tiny.search(queries, 10, 1, 2);
+    const auto sparseExact = BruteForceIndex(points.topRows(40)).search(queries, 10, 2);
+    results.push_back({sparse.indices.minCoeff() >= 0 && sparse.distances.allFinite(),
+                       "test_ivf: k neighbours when the probed lists hold fewer"});
+    results.push_back({(sparse.distances.array() >= sparseExact.distances.array() - 1e-4f).all(),
+                       "test_ivf: no neighbour closer than the exact ones"});
+}
+
+void test_classify(std::vector<std::pair<bool, std::string> > &results) {
+    const Eigen::VectorXi labels = (Eigen::VectorXi(5) << 3, 5, 5, 3, 1).finished();
+    Neighbours neighbours{Eigen::MatrixXi(3, 4), Eigen::MatrixXf::Zero(3, 4)};
+    neighbours.indices << 0, 1, 2, 3, // 5 reaches two votes before 3 does
+            1, 0, 4, 3, // 3 reaches two votes only at the last neighbour
+            -1, 4, -1, 0; // missing neighbours do not vote
+    const Eigen::VectorXi predicted = classify(neighbours, labels);
+    results.push_back({predicted(0) == 5 && predicted(1) == 3, "test_classify: ties go to the first to the count"});
+    results.push_back({predicted(2) == 1, "test_classify: -1 skipped"});
+
+    Eigen::MatrixXd oneHot = Eigen::MatrixXd::Zero(3, 10);
+    oneHot(0, 4) = oneHot(1, 0) = oneHot(2, 9) = 1.0;
+    results.push_back({labelsFromOneHot(oneHot) == (Eigen::VectorXi(3) << 4, 0, 9).finished(),
+                       "test_classify: labels from one-hot rows"});
+}
+
+void test_recall(std::vector<std::pair<bool, std::string> > &results) {
+    Neighbours exact{Eigen::MatrixXi(2, 2), Eigen::MatrixXf::Zero(2, 2)};
+    Neighbours approx{Eigen::MatrixXi(2, 2), Eigen::MatrixXf::Zero(2, 2)};
+    exact.indices << 1, 2,
+            3, 4;
+    approx.indices << 2, 1,
+            4, 7;
+    results.push_back({recall(approx, exact) == 0.75, "test_recall: order within a row does not matter"});
+    results.push_back({recall(exact, exact) == 1.0, "test_recall: exact against itself"});
+    results.push_back({throwsInvalid([&] { recall(Neighbours{Eigen::MatrixXi(1, 2), {}}, exact); }),
+                       "test_recall: row count mismatch throws"});
+}
+
+void test_check_query(std::vector<std::pair<bool, std::string> > &results) {
+    const Eigen::MatrixXd points = makePoints(30, 8, 5);
+    const BruteForceIndex exact(points);
+    const IVFIndex ivf(points, 4);
+    const Eigen::MatrixXd queries = makePoints(3, 8, 6);
+    const Eigen::MatrixXd wrong = makePoints(3, 9, 6);
+
+    results.push_back({throwsInvalid([&] { exact.search(queries, 0); })
+                       && throwsInvalid([&] { exact.search(queries, 31); })
+                       && throwsInvalid([&] { ivf.search(queries, 0); })
+                       && throwsInvalid([&] { ivf.search(queries, 31); }),
+                       "test_check_query: k out of range throws"});
+    results.push_back({throwsInvalid([&] { exact.search(wrong, 1); }) && throwsInvalid([&] { ivf.search(wrong, 1); }),
+                       "test_check_query: wrong dimension throws"});
+    results.push_back({throwsInvalid([&] { IVFIndex(Eigen::MatrixXd(0, 8)); }),
+                       "test_check_query: empty IVF index throws"});
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+
+    test_brute_force(results);
+    test_ivf(results);
+    test_classify(results);
+    test_recall(results);
+    test_check_query(results);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}
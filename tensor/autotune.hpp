@@ -0,0 +1,424 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "kernels.hpp"
+
+// Kernel autotuner.
+// The fastest KernelConfig depends on the cache hierarchy of the machine, so winners are
+// benchmarked per (op, dtype, shape class, thread budget) and persisted in a cache file keyed
+// by CPU model. One file can therefore be shared between different machines.
+//
+// Environment:
+//   ADVPT_TUNING_CACHE  path of the cache file (default ~/.cache/advpt_kernel_tuning)
+//   ADVPT_AUTOTUNE      off -> heuristics only, tune -> benchmark on a cache miss,
+//                       anything else -> use the cache, heuristics on a miss
+
+enum class KernelOp {
+    MatVec,
+    MatMul
+};
+
+enum class TuneMode {
+    Heuristic,
+    Cached,
+    Tune
+};
+
+struct TuningKey {
+    std::string cpu;
+    KernelOp op;
+    std::string dtype;
+    size_t shape_class;
+    size_t threads;
+
+    auto operator<=>(const TuningKey &) const = default;
+};
+
+// Model name of the CPU this process runs on, "unknown" if it cannot be determined.
+inline std::string cpuModel() {
+#ifdef __linux__
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0 || line.rfind("Model", 0) == 0) {
+            const size_t colon = line.find(':');
+            if (colon != std::string::npos && colon + 2 <= line.size()) {
+                return line.substr(colon + 2);
+            }
+        }
+    }
+#endif
+    return "unknown";
+}
+
+// Short name of a component type, e.g. f32, f64, i32, u8.
+template<Arithmetic ComponentType>
+std::string dtypeName() {
+    const char kind = std::is_floating_point_v<ComponentType> ? 'f' : std::is_signed_v<ComponentType> ? 'i' : 'u';
+    return kind + std::to_string(8 * sizeof(ComponentType));
+}
+
+// Working set size class: 0 fits L1, 1 fits L2, 2 fits L3, 3 streams from memory.
+inline size_t shapeClass(size_t bytes) noexcept {
+    if (bytes <= (size_t(32) << 10)) return 0;
+    if (bytes <= (size_t(1) << 20)) return 1;
+    if (bytes <= (size_t(32) << 20)) return 2;
+    return 3;
+}
+
+class Autotuner {
+public:
+    explicit Autotuner(std::string cache_path = defaultCachePath(), TuneMode mode = modeFromEnvironment());
+
+    // Process wide instance, loads the cache file on first use.
+    static Autotuner &global();
+
+    static std::string defaultCachePath();
+    static TuneMode modeFromEnvironment();
+
+    // Configuration for the given problem: cached winner, a fresh tuning run or heuristics,
+    // depending on the mode.
+    template<Arithmetic ComponentType>
+    KernelConfig matvecConfig(size_t rows, size_t cols, size_t threads = hardwareThreads());
+
+    template<Arithmetic ComponentType>
+    KernelConfig matmulConfig(size_t rows, size_t inner, size_t cols, size_t threads = hardwareThreads());
+
+    // Benchmarks all candidates on the given shape and stores the winner, independent of the mode.
+    template<Arithmetic ComponentType>
+    KernelConfig tuneMatvec(size_t rows, size_t cols, size_t threads = hardwareThreads());
+
+    template<Arithmetic ComponentType>
+    KernelConfig tuneMatmul(size_t rows, size_t inner, size_t cols, size_t threads = hardwareThreads());
+
+    // Reads the cache file, entries of other CPUs are kept but never used. Returns false if
+    // there is no readable cache.
+    bool load();
+
+    // Writes all entries back. Returns false if the file cannot be written.
+    bool save() const;
+
+    [[nodiscard]] TuneMode mode() const {return _mode;}
+    [[nodiscard]] const std::string &cachePath() const {return _cache_path;}
+
+    // Number of cached entries belonging to this CPU.
+    [[nodiscard]] size_t numEntries() const;
+
+private:
+    std::string _cache_path;
+    TuneMode _mode;
+    std::string _cpu;
+    std::map<TuningKey, KernelConfig> _entries;
+    mutable std::mutex _mutex;
+    std::atomic<bool> _save_failed{false};
+
+    [[nodiscard]] static KernelConfig heuristic(KernelOp op, size_t elem_size, size_t bytes, size_t cols,
+                                                size_t threads);
+
+    [[nodiscard]] static std::vector<KernelConfig> candidates(KernelOp op, size_t threads);
+
+    // Best wall time of fn in seconds.
+    template<class Function>
+    static double measure(Function fn);
+
+    template<Arithmetic ComponentType, class Tune>
+    KernelConfig lookup(KernelOp op, size_t bytes, size_t cols, size_t threads, Tune tune);
+
+    template<Arithmetic ComponentType, class Run>
+    KernelConfig tune(KernelOp op, size_t bytes, size_t threads, Run run);
+};
+
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Setup and persistence
+/////////////////////////////////////////////
+
+inline Autotuner::Autotuner(std::string cache_path, TuneMode mode) :
+    _cache_path(std::move(cache_path)),
+    _mode(mode),
+    _cpu(cpuModel()) {
+    if (_mode != TuneMode::Heuristic) {
+        load();
+    }
+}
+
+inline Autotuner &Autotuner::global() {
+    static Autotuner instance;
+    return instance;
+}
+
+inline std::string Autotuner::defaultCachePath() {
+    if (const char *path = std::getenv("ADVPT_TUNING_CACHE")) {
+        return path;
+    }
+    if (const char *home = std::getenv("HOME")) {
+        return std::string(home) + "/.cache/advpt_kernel_tuning";
+    }
+    return "advpt_kernel_tuning";
+}
+
+inline TuneMode Autotuner::modeFromEnvironment() {
+    const char *mode = std::getenv("ADVPT_AUTOTUNE");
+    if (mode == nullptr) {
+        return TuneMode::Cached;
+    }
+    const std::string value(mode);
+    if (value == "off" || value == "0") {
+        return TuneMode::Heuristic;
+    }
+    if (value == "tune" || value == "1") {
+        return TuneMode::Tune;
+    }
+    return TuneMode::Cached;
+}
+
+// One entry per line: <cpu model> TAB <op> <dtype> <class> <threads> TAB <rows> <cols> <unroll> <threads>
+inline bool Autotuner::load() {
+    std::ifstream file(_cache_path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::lock_guard lock(_mutex);
+    std::string line;
+    while (getline(file, line)) {
+        const size_t tab1 = line.find('\t');
+        const size_t tab2 = line.find('\t', tab1 + 1);
+        if (line.empty() || line[0] == '#' || tab1 == std::string::npos || tab2 == std::string::npos) {
+            continue;
+        }
+        TuningKey key;
+        KernelConfig config;
+        std::string op;
+        key.cpu = line.substr(0, tab1);
+        std::istringstream fields(line.substr(tab1 + 1));
+        if (!(fields >> op >> key.dtype >> key.shape_class >> key.threads
+                     >> config.block_rows >> config.block_cols >> config.unroll >> config.threads)
+            || (op != "matvec" && op != "matmul")) {
+            // ignore lines written by a different version
+            continue;
+        }
+        key.op = op == "matvec" ? KernelOp::MatVec : KernelOp::MatMul;
+        _entries[key] = config;
+    }
+    return true;
+}
+
+inline bool Autotuner::save() const {
+    // the default location under ~/.cache may not exist yet
+    const std::filesystem::path parent = std::filesystem::path(_cache_path).parent_path();
+    if (!parent.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(parent, error);
+    }
+    std::ofstream file(_cache_path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::lock_guard lock(_mutex);
+    file << "# kernel tuning cache, regenerate with pretune\n";
+    for (const auto &[key, config]: _entries) {
+        file << key.cpu << '\t' << (key.op == KernelOp::MatVec ? "matvec" : "matmul") << ' ' << key.dtype << ' '
+             << key.shape_class << ' ' << key.threads << '\t' << config.block_rows << ' ' << config.block_cols
+             << ' ' << config.unroll << ' ' << config.threads << '\n';
+    }
+    return file.good();
+}
+
+inline size_t Autotuner::numEntries() const {
+    std::lock_guard lock(_mutex);
+    return std::count_if(_entries.begin(), _entries.end(), [&](const auto &entry) {
+        return entry.first.cpu == _cpu;
+    });
+}
+
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Heuristics and candidates
+/////////////////////////////////////////////
+
+inline KernelConfig Autotuner::heuristic(KernelOp op, size_t elem_size, size_t bytes, size_t cols,
+                                         size_t threads) {
+    size_t l1 = 32 << 10;
+    size_t l2 = 1 << 20;
+#if defined(__linux__) && defined(_SC_LEVEL1_DCACHE_SIZE)
+    if (const long size = sysconf(_SC_LEVEL1_DCACHE_SIZE); size > 0) l1 = static_cast<size_t>(size);
+    if (const long size = sysconf(_SC_LEVEL2_CACHE_SIZE); size > 0) l2 = static_cast<size_t>(size);
+#endif
+    KernelConfig config;
+    config.block_rows = 16;
+    config.unroll = elem_size <= 4 ? 8 : 4;
+    if (op == KernelOp::MatVec) {
+        // half of L1 for the slice of the vector, the matrix rows stream past it
+        config.block_cols = std::max<size_t>(64, l1 / 2 / elem_size);
+        config.threads = bytes < (size_t(256) << 10) ? 1 : threads;
+    } else {
+        // a block of rhs rows should stay in L2 while the row block sweeps over it
+        config.block_cols = std::max<size_t>(8, l2 / 2 / (std::max<size_t>(1, cols) * elem_size));
+        config.threads = bytes < (size_t(64) << 10) ? 1 : threads;
+    }
+    return config;
+}
+
+inline std::vector<KernelConfig> Autotuner::candidates(KernelOp op, size_t threads) {
+    std::vector<size_t> thread_counts = {1};
+    if (threads > 2) thread_counts.push_back(threads / 2);
+    if (threads > 1) thread_counts.push_back(threads);
+
+    const std::vector<size_t> rows = op == KernelOp::MatVec ? std::vector<size_t>{4, 16, 64}
+                                                            : std::vector<size_t>{8, 32};
+    const std::vector<size_t> cols = op == KernelOp::MatVec ? std::vector<size_t>{256, 2048, 16384}
+                                                            : std::vector<size_t>{32, 128, 512};
+    std::vector<KernelConfig> result;
+    for (size_t t: thread_counts) {
+        for (size_t r: rows) {
+            for (size_t c: cols) {
+                for (size_t u: {1, 4, 8}) {
+                    result.push_back({r, c, u, t});
+                }
+            }
+        }
+    }
+    return result;
+}
+
+template<class Function>
+double Autotuner::measure(Function fn) {
+    using clock = std::chrono::steady_clock;
+    fn();
+    double best = 1e300;
+    double total = 0;
+    for (int rep = 0; rep < 10 && (rep < 2 || total < 0.02); ++rep) {
+        const auto start = clock::now();
+        fn();
+        const std::chrono::duration<double> elapsed = clock::now() - start;
+        best = std::min(best, elapsed.count());
+        total += elapsed.count();
+    }
+    return best;
+}
+
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Lookup and tuning
+/////////////////////////////////////////////
+
+template<Arithmetic ComponentType, class Tune>
+KernelConfig Autotuner::lookup(KernelOp op, size_t bytes, size_t cols, size_t threads, Tune tune) {
+    threads = std::max<size_t>(1, threads);
+    if (_mode != TuneMode::Heuristic) {
+        std::lock_guard lock(_mutex);
+        TuningKey key{_cpu, op, dtypeName<ComponentType>(), shapeClass(bytes), threads};
+        if (auto it = _entries.find(key); it != _entries.end()) {
+            return it->second;
+        }
+        // pretune skips the largest classes where tuning is expensive, the next smaller one is close
+        while (_mode == TuneMode::Cached && key.shape_class-- > 0) {
+            if (auto it = _entries.find(key); it != _entries.end()) {
+                return it->second;
+            }
+        }
+    }
+    if (_mode == TuneMode::Tune) {
+        const KernelConfig config = tune();
+        if (!save() && !_save_failed.exchange(true)) {
+            // reported once, the tuned configs still serve this process
+            std::cerr << "Autotuner: unable to write " << _cache_path << ", tuning results are not persisted"
+                      << std::endl;
+        }
+        return config;
+    }
+    return heuristic(op, sizeof(ComponentType), bytes, cols, threads);
+}
+
+template<Arithmetic ComponentType, class Run>
+KernelConfig Autotuner::tune(KernelOp op, size_t bytes, size_t threads, Run run) {
+    threads = std::max<size_t>(1, threads);
+    KernelConfig best;
+    double best_time = 1e300;
+    for (const KernelConfig &config: candidates(op, threads)) {
+        const double time = measure([&] { run(config); });
+        if (time < best_time) {
+            best_time = time;
+            best = config;
+        }
+    }
+    std::lock_guard lock(_mutex);
+    _entries[{_cpu, op, dtypeName<ComponentType>(), shapeClass(bytes), threads}] = best;
+    return best;
+}
+
+template<Arithmetic ComponentType>
+KernelConfig Autotuner::matvecConfig(size_t rows, size_t cols, size_t threads) {
+    const size_t bytes = (rows * cols + rows + cols) * sizeof(ComponentType);
+    return lookup<ComponentType>(KernelOp::MatVec, bytes, cols, threads, [&] {
+        return tuneMatvec<ComponentType>(rows, cols, threads);
+    });
+}
+
+template<Arithmetic ComponentType>
+KernelConfig Autotuner::matmulConfig(size_t rows, size_t inner, size_t cols, size_t threads) {
+    const size_t bytes = (rows * inner + inner * cols + rows * cols) * sizeof(ComponentType);
+    return lookup<ComponentType>(KernelOp::MatMul, bytes, cols, threads, [&] {
+        return tuneMatmul<ComponentType>(rows, inner, cols, threads);
+    });
+}
+
+template<Arithmetic ComponentType>
+KernelConfig Autotuner::tuneMatvec(size_t rows, size_t cols, size_t threads) {
+    std::vector<ComponentType> mat(rows * cols);
+    std::vector<ComponentType> vec(cols);
+    std::vector<ComponentType> out(rows);
+    for (size_t i = 0; i < mat.size(); ++i) mat[i] = static_cast<ComponentType>(i % 7 + 1);
+    for (size_t i = 0; i < vec.size(); ++i) vec[i] = static_cast<ComponentType>(i % 3 + 1);
+
+    const size_t bytes = (rows * cols + rows + cols) * sizeof(ComponentType);
+    return tune<ComponentType>(KernelOp::MatVec, bytes, threads, [&](const KernelConfig &config) {
+        matvecKernel(mat.data(), vec.data(), out.data(), rows, cols, config);
+    });
+}
+
+template<Arithmetic ComponentType>
+KernelConfig Autotuner::tuneMatmul(size_t rows, size_t inner, size_t cols, size_t threads) {
+    std::vector<ComponentType> lhs(rows * inner);
+    std::vector<ComponentType> rhs(inner * cols);
+    std::vector<ComponentType> out(rows * cols);
+    for (size_t i = 0; i < lhs.size(); ++i) lhs[i] = static_cast<ComponentType>(i % 7 + 1);
+    for (size_t i = 0; i < rhs.size(); ++i) rhs[i] = static_cast<ComponentType>(i % 3 + 1);
+
+    const size_t bytes = (rows * inner + inner * cols + rows * cols) * sizeof(ComponentType);
+    return tune<ComponentType>(KernelOp::MatMul, bytes, threads, [&](const KernelConfig &config) {
+        matmulKernel(lhs.data(), rhs.data(), out.data(), rows, inner, cols, config);
+    });
+}
+
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Tuned front ends
+/////////////////////////////////////////////
+
+// Performs a matrix-vector multiplication with the configuration tuned for this machine.
+template<Arithmetic ComponentType>
+Vector<ComponentType> tunedMatvec(const Matrix<ComponentType> &mat, const Vector<ComponentType> &vec,
+                                  size_t threads = hardwareThreads()) {
+    return matvec(mat, vec, Autotuner::global().matvecConfig<ComponentType>(mat.rows(), mat.cols(), threads));
+}
+
+// Performs a matrix-matrix multiplication with the configuration tuned for this machine.
+template<Arithmetic ComponentType>
+Matrix<ComponentType> tunedMatmul(const Matrix<ComponentType> &lhs, const Matrix<ComponentType> &rhs,
+                                  size_t threads = hardwareThreads()) {
+    return matmul(lhs, rhs,
+                  Autotuner::global().matmulConfig<ComponentType>(lhs.rows(), lhs.cols(), rhs.cols(), threads));
+}
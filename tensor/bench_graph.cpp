@@ -0,0 +1,55 @@
+#include <chrono>
+
+#include "graph.hpp"
+
+// Compares eager evaluation with the fused and arena planned graph on a dense network.
+// Usage: bench_graph [width] [layers] [batch] [repetitions]
+
+int main(int argc, char *argv[]) {
+    const size_t width = argc > 1 ? std::stoul(argv[1]) : 512;
+    const size_t layers = argc > 2 ? std::stoul(argv[2]) : 8;
+    const size_t batch = argc > 3 ? std::stoul(argv[3]) : 64;
+    const size_t reps = argc > 4 ? std::stoul(argv[4]) : 5;
+
+    std::vector<Tensor<float>> biases;
+    for (size_t l = 0; l < layers; ++l) {
+        biases.emplace_back(std::vector<size_t>{batch, width}, 0.01f * static_cast<float>(l));
+    }
+    Tensor<float> square({width, width});
+    for (size_t i = 0; i < square.numElements(); ++i) {
+        square.Flat_idx(i) = static_cast<float>(i % 7) * 0.001f;
+    }
+    Tensor<float> x({batch, width}, 1.0f);
+
+    // each layer: relu(h W + b) * 0.5
+    Graph<float> g;
+    auto W = g.input(square);
+    auto h = g.input(x);
+    for (size_t l = 0; l < layers; ++l) {
+        h = g.scale(g.relu(g.add(g.matmul(h, W), g.input(biases[l]))), 0.5f);
+    }
+    g.compile({h});
+
+    auto time = [&](auto &&fn) {
+        double best = 1e300;
+        for (size_t r = 0; r < reps; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    };
+
+    Tensor<float> eager_out;
+    Tensor<float> lazy_out;
+    const double eager = time([&] { eager_out = std::move(g.runEager({h})[0]); });
+    const double lazy = time([&] { lazy_out = std::move(g.run()[0]); });
+
+    std::cout << "layers " << layers << ", batch " << batch << ", width " << width << "\n"
+              << "eager: " << eager * 1e3 << " ms, intermediates " << g.eagerBytes() / 1024 << " KiB\n"
+              << "graph: " << lazy * 1e3 << " ms, arena " << g.arenaBytes() / 1024 << " KiB, "
+              << g.numKernels() << " kernels\n"
+              << "results equal: " << (eager_out == lazy_out ? "yes" : "no") << std::endl;
+    return eager_out == lazy_out ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+
+#include "kernels.hpp"
+#include "numa.hpp"
+
+// Memory bandwidth of pinned workers for the different NUMA placements of a large tensor,
+// and batched matvec reading shared versus node-local replicated weights.
+// Usage: bench_numa [MiB] [threads] [repetitions]
+
+template<class Function>
+double best_time(size_t reps, Function fn) {
+    double best = 1e300;
+    for (size_t r = 0; r < reps; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    const size_t mib = argc > 1 ? std::stoul(argv[1]) : 512;
+    const size_t threads = argc > 2 ? std::stoul(argv[2]) : hardwareThreads();
+    const size_t reps = argc > 3 ? std::stoul(argv[3]) : 5;
+
+    const size_t cols = 4096;
+    const size_t rows = std::max<size_t>(1, (mib << 20) / (cols * sizeof(float)));
+    const size_t grain = 64;
+
+    std::cout << "NUMA nodes: " << numaNodes() << (numaEnabled() ? "" : " (placement disabled)") << "\n"
+              << "threads: " << threads << ", tensor: " << rows << "x" << cols << " floats" << std::endl;
+
+    setThreadAffinity(ThreadAffinity::Spread);
+    for (NumaPolicy policy: {NumaPolicy::Default, NumaPolicy::Interleave, NumaPolicy::Partitioned}) {
+        // first touched by the main thread only, as the Tensor constructor does
+        Tensor<float> a({rows, cols}, 1.0f);
+        Tensor<float> b({rows, cols}, 2.0f);
+        placeTensor(a, policy, threads, grain);
+        placeTensor(b, policy, threads, grain);
+
+        // triad b = b + 0.5 a, two reads and one write per element
+        const double seconds = best_time(reps, [&] {
+            parallelFor(0, rows, grain, threads, [&](size_t begin, size_t end) {
+                float *dst = b.data();
+                const float *src = a.data();
+                for (size_t i = begin * cols; i < end * cols; ++i) {
+                    dst[i] += 0.5f * src[i];
+                }
+            });
+        });
+        const char *name = policy == NumaPolicy::Default ? "first touch" :
+                           policy == NumaPolicy::Interleave ? "interleave" : "partitioned";
+        std::cout << name << ": " << 3.0 * static_cast<double>(a.numElements() * sizeof(float)) / seconds / 1e9
+                  << " GB/s" << std::endl;
+    }
+
+    // every worker multiplies the full weight matrix with its own vectors
+    Tensor<float> weights({2048, 2048}, 0.001f);
+    NumaReplicas<float> replicas(weights);
+    const size_t batch = 4 * threads;
+    Tensor<float> inputs({batch, 2048}, 1.0f);
+    Tensor<float> outputs({batch, 2048});
+    const KernelConfig serial{16, 2048, 4, 1};
+    for (bool replicated: {false, true}) {
+        const double seconds = best_time(reps, [&] {
+            parallelFor(0, batch, 1, threads, [&](size_t begin, size_t end) {
+                const Tensor<float> &w = replicated ? replicas.local() : weights;
+                for (size_t v = begin; v < end; ++v) {
+                    matvecKernel(w.data(), inputs.data() + v * 2048, outputs.data() + v * 2048, 2048, 2048, serial);
+                }
+            });
+        });
+        std::cout << (replicated ? "replicated" : "shared") << " weights (" << replicas.numReplicas()
+                  << " copies): " << static_cast<double>(batch * weights.numElements() * sizeof(float)) / seconds / 1e9
+                  << " GB/s" << std::endl;
+    }
+    setThreadAffinity(ThreadAffinity::None);
+    return 0;
+}
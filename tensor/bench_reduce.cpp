@@ -0,0 +1,78 @@
+#include <chrono>
+#include <cmath>
+
+#include "broadcast.hpp"
+#include "reduce.hpp"
+
+// Axis reductions over rank 3 and rank 4 tensors along every axis: the blocked reduction on one
+// and on all threads against the loop through operator() it replaces. Ends with a softmax style
+// broadcast, subtracting the maximum along the last axis.
+// Usage: bench_reduce [MiB] [threads] [repetitions]
+
+template<class Function>
+double best_time(size_t reps, Function fn) {
+    double best = 1e300;
+    for (size_t r = 0; r < reps; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// Sum along axis the way it had to be written before, one vector index per element.
+Tensor<float> naive_sum(const Tensor<float> &tensor, size_t axis) {
+    const auto shape = tensor.shape();
+    Tensor<float> result(reducedShape(shape, axis, true));
+    std::vector<size_t> idx(shape.size(), 0);
+    for (size_t flat = 0; flat < tensor.numElements(); ++flat) {
+        auto out = idx;
+        out[axis] = 0;
+        result(out) += tensor(idx);
+        for (size_t d = shape.size(); d-- > 0;) {
+            if (++idx[d] < shape[d]) break;
+            idx[d] = 0;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    const size_t mib = argc > 1 ? std::stoul(argv[1]) : 64;
+    const size_t threads = argc > 2 ? std::stoul(argv[2]) : hardwareThreads();
+    const size_t reps = argc > 3 ? std::stoul(argv[3]) : 5;
+
+    const size_t elements = (mib << 20) / sizeof(float);
+    const size_t side3 = static_cast<size_t>(std::cbrt(static_cast<double>(elements)));
+    const size_t side4 = static_cast<size_t>(std::sqrt(std::sqrt(static_cast<double>(elements))));
+    std::cout << "threads: " << threads << std::endl;
+
+    volatile float sink = 0;
+    for (const std::vector<size_t> &shape: {std::vector<size_t>{side3, side3, side3},
+                                            std::vector<size_t>{side4, side4, side4, side4}}) {
+        Tensor<float> t(shape);
+        for (size_t i = 0; i < t.numElements(); ++i) t.Flat_idx(i) = static_cast<float>(i % 13) * 0.125f;
+        const double bytes = static_cast<double>(t.numElements() * sizeof(float));
+        std::cout << "rank " << shape.size() << ", " << shape[0] << " per axis (" << bytes / (1 << 20) << " MiB)"
+                  << std::endl;
+
+        for (size_t axis = 0; axis < shape.size(); ++axis) {
+            const double naive = best_time(1, [&] { sink = naive_sum(t, axis).Flat_idx(0); });
+            const double serial = best_time(reps, [&] { sink = sum(t, axis, false, 1).Flat_idx(0); });
+            const double parallel = best_time(reps, [&] { sink = sum(t, axis, false, threads).Flat_idx(0); });
+            const double arg = best_time(reps, [&] {
+                sink = static_cast<float>(argmax(t, axis, false, threads).Flat_idx(0));
+            });
+            std::cout << "  sum axis " << axis << ": operator() " << bytes / naive / 1e9 << " GB/s, blocked "
+                      << bytes / serial / 1e9 << " GB/s, " << threads << " threads " << bytes / parallel / 1e9
+                      << " GB/s; argmax " << bytes / arg / 1e9 << " GB/s" << std::endl;
+        }
+
+        const double softmax = best_time(reps, [&] {
+            sink = subtract(t, max(t, shape.size() - 1, true, threads), threads).Flat_idx(0);
+        });
+        std::cout << "  x - max(x, last axis): " << 2.0 * bytes / softmax / 1e9 << " GB/s" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <chrono>
+#include <sys/resource.h>
+
+#include "streaming.hpp"
+
+// Throughput and peak memory of streamed matvec over a matrix file much larger than the panel
+// budget. The file is written panel by panel and evicted from the page cache before every run,
+// so reads come from disk.
+// Usage: bench_streaming [matrix MiB] [budget MiB] [file]
+
+namespace {
+    size_t peakRssKiB() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<size_t>(usage.ru_maxrss);
+    }
+
+    void evict(const std::string &filename) {
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const size_t mib = argc > 1 ? std::stoul(argv[1]) : 1024;
+    const size_t budget_mib = argc > 2 ? std::stoul(argv[2]) : 32;
+    const std::string filename = argc > 3 ? argv[3] : "bench_streaming_matrix";
+
+    const size_t cols = 8192;
+    const size_t rows = std::max<size_t>(1, (mib << 20) / (cols * sizeof(float)));
+    {
+        std::ofstream out(filename, std::ios::binary);
+        writeBinaryHeader<float>(out, {rows, cols});
+        std::vector<float> row(cols);
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < cols; ++c) row[c] = static_cast<float>((r + c) % 17) * 0.01f;
+            out.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(cols * sizeof(float)));
+        }
+    }
+    const double bytes = static_cast<double>(rows * cols * sizeof(float));
+    std::cout << "matrix " << rows << "x" << cols << " (" << bytes / (1 << 20) << " MiB), panel budget "
+              << budget_mib << " MiB, peak RSS after writing " << peakRssKiB() / 1024 << " MiB" << std::endl;
+
+    Vector<float> x(cols, 1.0f);
+    for (bool use_mmap: {false, true}) {
+        StreamConfig config;
+        config.memory_budget = budget_mib << 20;
+        config.use_mmap = use_mmap;
+        evict(filename);
+        const auto start = std::chrono::steady_clock::now();
+        const auto y = streamingMatvec(filename, x, config);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << (use_mmap ? "mmap: " : "read: ") << bytes / elapsed.count() / 1e6 << " MB/s, peak RSS "
+                  << peakRssKiB() / 1024 << " MiB, y(0) = " << y(0) << std::endl;
+    }
+    std::remove(filename.c_str());
+    return 0;
+}
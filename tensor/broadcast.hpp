@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+
+#include "parallel.hpp"
+#include "tensor.hpp"
+
+// Elementwise binary operations with numpy broadcasting.
+// Shapes are aligned at their last dimension, missing leading dimensions count as 1 and a
+// dimension of 1 is repeated to match the other operand. Neighbouring dimensions that are
+// contiguous in both operands are merged first, so the innermost loop runs over the longest
+// possible contiguous row of the result, with each operand either contiguous or a repeated
+// scalar. The rows are split between threads.
+
+// result rows per parallelFor chunk are chosen to cover at least this many elements
+inline constexpr size_t broadcast_chunk_elements = size_t(1) << 15;
+
+inline std::vector<size_t> broadcastShape(const std::vector<size_t> &a, const std::vector<size_t> &b) {
+    const size_t rank = std::max(a.size(), b.size());
+    std::vector<size_t> result(rank);
+    for (size_t d = 0; d < rank; ++d) {
+        const size_t da = d + a.size() >= rank ? a[d + a.size() - rank] : 1;
+        const size_t db = d + b.size() >= rank ? b[d + b.size() - rank] : 1;
+        if (da != db && da != 1 && db != 1) {
+            throw std::invalid_argument("Shapes cannot be broadcast together");
+        }
+        result[d] = da == 1 ? db : da;
+    }
+    return result;
+}
+
+// Element strides of an operand in the iteration space of shape, 0 along broadcast dimensions.
+inline std::vector<size_t> broadcastStrides(const std::vector<size_t> &operand, const std::vector<size_t> &shape) {
+    std::vector<size_t> strides(shape.size(), 0);
+    size_t stride = 1;
+    for (size_t i = operand.size(); i-- > 0;) {
+        const size_t d = i + shape.size() - operand.size();
+        strides[d] = operand[i] == 1 ? 0 : stride;
+        stride *= operand[i];
+    }
+    return strides;
+}
+
+// out = op(a, b) elementwise after broadcasting both to a common shape.
+template<Arithmetic ComponentType, class Op>
+Tensor<ComponentType> broadcastApply(const Tensor<ComponentType> &a, const Tensor<ComponentType> &b, Op op,
+                                     size_t threads = hardwareThreads()) {
+    const auto shape_a = a.shape();
+    const auto shape_b = b.shape();
+    const auto shape = broadcastShape(shape_a, shape_b);
+    Tensor<ComponentType> result(shape);
+    if (result.numElements() == 0) {
+        return result;
+    }
+    const auto strides_a = broadcastStrides(shape_a, shape);
+    const auto strides_b = broadcastStrides(shape_b, shape);
+
+    // merge dimension d into d + 1 wherever both operands step through them contiguously
+    std::vector<size_t> dims, sa, sb;
+    for (size_t d = 0; d < shape.size(); ++d) {
+        if (shape[d] == 1) {
+            continue;
+        }
+        if (!dims.empty() && sa.back() == strides_a[d] * shape[d] && sb.back() == strides_b[d] * shape[d]) {
+            dims.back() *= shape[d];
+            sa.back() = strides_a[d];
+            sb.back() = strides_b[d];
+        } else {
+            dims.push_back(shape[d]);
+            sa.push_back(strides_a[d]);
+            sb.push_back(strides_b[d]);
+        }
+    }
+    if (dims.empty()) {
+        dims = {1};
+        sa = {0};
+        sb = {0};
+    }
+
+    const size_t inner = dims.back();
+    const size_t rows = result.numElements() / inner;
+    const size_t outer_rank = dims.size() - 1;
+    const ComponentType *pa = a.data();
+    const ComponentType *pb = b.data();
+    ComponentType *out = result.data();
+
+    parallelFor(0, rows, std::max<size_t>(1, broadcast_chunk_elements / inner), threads,
+                [&](size_t begin, size_t end) {
+        // coordinates of the first row of the chunk, then counted up like an odometer
+        std::vector<size_t> coord(outer_rank);
+        size_t offset_a = 0;
+        size_t offset_b = 0;
+        for (size_t d = outer_rank, rest = begin; d-- > 0;) {
+            coord[d] = rest % dims[d];
+            rest /= dims[d];
+            offset_a += coord[d] * sa[d];
+            offset_b += coord[d] * sb[d];
+        }
+        for (size_t row = begin; row < end; ++row) {
+            const ComponentType *ra = pa + offset_a;
+            const ComponentType *rb = pb + offset_b;
+            ComponentType *ro = out + row * inner;
+            if (sa.back() == 1 && sb.back() == 1) {
+                for (size_t j = 0; j < inner; ++j) ro[j] = op(ra[j], rb[j]);
+            } else if (sa.back() == 1) {
+                const ComponentType y = rb[0];
+                for (size_t j = 0; j < inner; ++j) ro[j] = op(ra[j], y);
+            } else if (sb.back() == 1) {
+                const ComponentType x = ra[0];
+                for (size_t j = 0; j < inner; ++j) ro[j] = op(x, rb[j]);
+            } else {
+                const ComponentType value = op(ra[0], rb[0]);
+                std::fill(ro, ro + inner, value);
+            }
+            for (size_t d = outer_rank; d-- > 0;) {
+                offset_a += sa[d];
+                offset_b += sb[d];
+                if (++coord[d] < dims[d]) {
+                    break;
+                }
+                offset_a -= coord[d] * sa[d];
+                offset_b -= coord[d] * sb[d];
+                coord[d] = 0;
+            }
+        }
+    });
+    return result;
+}
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Arithmetic
+/////////////////////////////////////////////
+
+template<Arithmetic ComponentType>
+Tensor<ComponentType> add(const Tensor<ComponentType> &a, const Tensor<ComponentType> &b,
+                          size_t threads = hardwareThreads()) {
+    return broadcastApply(a, b, [](ComponentType x, ComponentType y) { return x + y; }, threads);
+}
+
+template<Arithmetic ComponentType>
+Tensor<ComponentType> subtract(const Tensor<ComponentType> &a, const Tensor<ComponentType> &b,
+                               size_t threads = hardwareThreads()) {
+    return broadcastApply(a, b, [](ComponentType x, ComponentType y) { return x - y; }, threads);
+}
+
+template<Arithmetic ComponentType>
+Tensor<ComponentType> multiply(const Tensor<ComponentType> &a, const Tensor<ComponentType> &b,
+                               size_t threads = hardwareThreads()) {
+    return broadcastApply(a, b, [](ComponentType x, ComponentType y) { return x * y; }, threads);
+}
+
+template<Arithmetic ComponentType>
+Tensor<ComponentType> divide(const Tensor<ComponentType> &a, const Tensor<ComponentType> &b,
+                             size_t threads = hardwareThreads()) {
+    return broadcastApply(a, b, [](ComponentType x, ComponentType y) { return x / y; }, threads);
+}
+
+template<Arithmetic ComponentType>
+Tensor<ComponentType> maximum(const Tensor<ComponentType> &a, const Tensor<ComponentType> &b,
+                              size_t threads = hardwareThreads()) {
+    return broadcastApply(a, b, [](ComponentType x, ComponentType y) { return x > y ? x : y; }, threads);
+}
@@ -0,0 +1,11 @@
+#include <iostream>
+#include "IO.hpp"
+#include "eigen_interop.hpp"
+int main(){
+  auto images = IO_MNIST::loadMnistImages("img.idx3-ubyte", 2, 4, 5);
+  IO_MNIST::writeTensorToFile(images.row(1).reshaped(4,5), "t");
+  auto fromFile = readTensorFromFile<double>("t");
+  auto copied = rowAsTensorView(images, 1, 4, 5).toTensor();
+  std::cout << "shapes " << fromFile.shape()[0] << "x" << fromFile.shape()[1] << " equal=" << (fromFile==copied) << "\n";
+  std::cout << fromFile({0,1}) << " vs " << copied({0,1}) << "\n";
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+#include "tensor_view.hpp"
+
+// Zero-copy adapters between Tensor storage and Eigen.
+// Tensors are row-major with the last index fastest, so rank 2 tensors map to row-major Eigen
+// matrices. Eigen objects with direct access (matrices, blocks, rows, maps) become TensorViews
+// with Eigen's strides, whatever their storage order.
+
+template<Arithmetic ComponentType>
+using RowMajorMatrix = Eigen::Matrix<ComponentType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+template<Arithmetic ComponentType>
+using StridedMap = Eigen::Map<RowMajorMatrix<ComponentType>, Eigen::Unaligned,
+                              Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
+template<Arithmetic ComponentType>
+using ConstStridedMap = Eigen::Map<const RowMajorMatrix<ComponentType>, Eigen::Unaligned,
+                                   Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Tensor -> Eigen
+/////////////////////////////////////////////
+
+// Rank 2 tensor as a row-major Eigen matrix sharing its storage.
+template<Arithmetic ComponentType>
+Eigen::Map<RowMajorMatrix<ComponentType>> asEigen(Tensor<ComponentType> &tensor) {
+    if (tensor.rank() != 2) {
+        throw std::invalid_argument("asEigen: tensor is not of rank 2");
+    }
+    const auto shape = tensor.shape();
+    return {tensor.data(), static_cast<Eigen::Index>(shape[0]), static_cast<Eigen::Index>(shape[1])};
+}
+
+template<Arithmetic ComponentType>
+Eigen::Map<const RowMajorMatrix<ComponentType>> asEigen(const Tensor<ComponentType> &tensor) {
+    if (tensor.rank() != 2) {
+        throw std::invalid_argument("asEigen: tensor is not of rank 2");
+    }
+    const auto shape = tensor.shape();
+    return {tensor.data(), static_cast<Eigen::Index>(shape[0]), static_cast<Eigen::Index>(shape[1])};
+}
+
+// Tensor of any rank as a flat Eigen column vector sharing its storage.
+template<Arithmetic ComponentType>
+Eigen::Map<Eigen::Vector<ComponentType, Eigen::Dynamic>> asEigenVector(Tensor<ComponentType> &tensor) {
+    return {tensor.data(), static_cast<Eigen::Index>(tensor.numElements())};
+}
+
+template<Arithmetic ComponentType>
+Eigen::Map<const Eigen::Vector<ComponentType, Eigen::Dynamic>> asEigenVector(const Tensor<ComponentType> &tensor) {
+    return {tensor.data(), static_cast<Eigen::Index>(tensor.numElements())};
+}
+
+// Rank 2 view, possibly strided, as an Eigen map with the same strides.
+template<Arithmetic ComponentType>
+StridedMap<ComponentType> asEigen(const TensorView<ComponentType> &view) requires (!std::is_const_v<ComponentType>) {
+    if (view.rank() != 2) {
+        throw std::invalid_argument("asEigen: view is not of rank 2");
+    }
+    return {view.data(), static_cast<Eigen::Index>(view.shape()[0]), static_cast<Eigen::Index>(view.shape()[1]),
+            {static_cast<Eigen::Index>(view.strides()[0]), static_cast<Eigen::Index>(view.strides()[1])}};
+}
+
+template<Arithmetic ComponentType>
+ConstStridedMap<std::remove_const_t<ComponentType>> asEigen(const TensorView<ComponentType> &view)
+    requires std::is_const_v<ComponentType> {
+    if (view.rank() != 2) {
+        throw std::invalid_argument("asEigen: view is not of rank 2");
+    }
+    return {view.data(), static_cast<Eigen::Index>(view.shape()[0]), static_cast<Eigen::Index>(view.shape()[1]),
+            {static_cast<Eigen::Index>(view.strides()[0]), static_cast<Eigen::Index>(view.strides()[1])}};
+}
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Eigen -> Tensor
+/////////////////////////////////////////////
+
+// Eigen matrix or block as a rank 2 view sharing its storage.
+template<class Derived>
+TensorView<typename Derived::Scalar> asTensorView(Eigen::PlainObjectBase<Derived> &matrix) {
+    return {matrix.data(), {static_cast<size_t>(matrix.rows()), static_cast<size_t>(matrix.cols())},
+            {static_cast<size_t>(matrix.rowStride()), static_cast<size_t>(matrix.colStride())}};
+}
+
+// Read-only variant, also binds to temporaries like matrix.row(i) or a block.
+template<class Derived>
+TensorView<const typename Derived::Scalar> asTensorView(const Eigen::DenseBase<Derived> &matrix) {
+    static_assert(static_cast<bool>(Derived::Flags & Eigen::DirectAccessBit),
+                  "asTensorView needs an Eigen object with direct memory access");
+    const Derived &m = matrix.derived();
+    return {m.data(), {static_cast<size_t>(m.rows()), static_cast<size_t>(m.cols())},
+            {static_cast<size_t>(m.rowStride()), static_cast<size_t>(m.colStride())}};
+}
+
+// Row of an Eigen matrix holding a flattened image (or any rank 2 entry) as a rows x cols
+// view, the pixels of the row being in row-major order like the IDX files store them. Note that
+// row.reshaped(rows, cols), as read_dataset writes images, fills column by column and yields
+// the transpose; row.reshaped(cols, rows).transpose() matches this view.
+template<class Derived>
+TensorView<const typename Derived::Scalar> rowAsTensorView(const Eigen::DenseBase<Derived> &matrix, Eigen::Index row,
+                                                          size_t rows, size_t cols) {
+    static_assert(static_cast<bool>(Derived::Flags & Eigen::DirectAccessBit),
+                  "rowAsTensorView needs an Eigen object with direct memory access");
+    const Derived &m = matrix.derived();
+    if (row < 0 || row >= m.rows() || static_cast<size_t>(m.cols()) != rows * cols) {
+        throw std::out_of_range("rowAsTensorView: row or shape does not fit the matrix");
+    }
+    const auto pixel = static_cast<size_t>(m.colStride());
+    return {m.data() + row * m.rowStride(), {rows, cols}, {cols * pixel, pixel}};
+}
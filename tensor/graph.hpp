@@ -0,0 +1,468 @@
+#pragma once
+
+#include <algorithm>
+
+#include "tensor.hpp"
+
+// Lazy computation graph over Tensor.
+// Operations are only recorded. compile() fuses chains of elementwise ops into the epilogue
+// of the kernel producing their first operand and plans all intermediates into one arena,
+// run() then executes the plan without allocating per operation.
+
+enum class GraphOp {
+    Input,
+    MatVec,
+    MatMul,
+    Add,
+    Mul,
+    Scale,
+    Relu
+};
+
+template<Arithmetic ComponentType>
+class Graph {
+public:
+    using NodeId = size_t;
+
+    // Records a leaf. The tensor is referenced, not copied, and has to outlive run().
+    NodeId input(const Tensor<ComponentType> &tensor);
+
+    // mat [m, n] times vec [n] -> [m]
+    NodeId matvec(NodeId mat, NodeId vec);
+
+    // lhs [m, k] times rhs [k, n] -> [m, n]
+    NodeId matmul(NodeId lhs, NodeId rhs);
+
+    // Elementwise ops, both operands need the same shape.
+    NodeId add(NodeId lhs, NodeId rhs);
+    NodeId mul(NodeId lhs, NodeId rhs);
+
+    NodeId scale(NodeId node, const ComponentType &factor);
+    NodeId relu(NodeId node);
+
+    [[nodiscard]] std::vector<size_t> shape(NodeId node) const;
+
+    // Fuses the nodes needed for outputs into kernels and assigns arena offsets to all
+    // intermediates. Recording further nodes afterwards requires another compile().
+    void compile(const std::vector<NodeId> &outputs);
+
+    // Executes the compiled plan and returns one tensor per output.
+    std::vector<Tensor<ComponentType>> run();
+
+    // Reference path: evaluates every node on its own into a freshly allocated tensor.
+    std::vector<Tensor<ComponentType>> runEager(const std::vector<NodeId> &outputs) const;
+
+    // Number of kernels in the compiled plan (one per node in eager mode).
+    [[nodiscard]] size_t numKernels() const {return _kernels.size();}
+
+    // Bytes of the shared arena holding all intermediates of the compiled plan.
+    [[nodiscard]] size_t arenaBytes() const {return _arena.size() * sizeof(ComponentType);}
+
+    // Bytes eager mode materialises for the same intermediates (outputs excluded).
+    [[nodiscard]] size_t eagerBytes() const {return _eager_bytes;}
+
+private:
+    struct Node {
+        GraphOp op;
+        std::vector<NodeId> args;
+        std::vector<size_t> shape;
+        ComponentType scalar;
+        const Tensor<ComponentType> *leaf;
+    };
+
+    // A root op followed by elementwise ops that each consume the previous value.
+    struct Kernel {
+        std::vector<NodeId> nodes;
+        size_t offset;
+        bool is_output;
+    };
+
+    std::vector<Node> _nodes;
+    std::vector<Kernel> _kernels;
+    std::vector<NodeId> _outputs;
+    std::vector<ComponentType> _arena;
+    size_t _eager_bytes = 0;
+    bool _compiled = false;
+
+    NodeId record(Node node);
+
+    void checkNode(NodeId node) const;
+
+    [[nodiscard]] static bool isElementwise(GraphOp op) noexcept;
+
+    [[nodiscard]] ComponentType apply(const Node &node, ComponentType value, size_t idx,
+                                      const std::vector<const ComponentType *> &values) const;
+
+    void execute(const Kernel &kernel, ComponentType *dst,
+                 const std::vector<const ComponentType *> &values) const;
+};
+
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Recording
+/////////////////////////////////////////////
+
+template<Arithmetic ComponentType>
+typename Graph<ComponentType>::NodeId Graph<ComponentType>::record(Node node) {
+    _compiled = false;
+    _nodes.push_back(std::move(node));
+    return _nodes.size() - 1;
+}
+
+template<Arithmetic ComponentType>
+void Graph<ComponentType>::checkNode(NodeId node) const {
+    if (node >= _nodes.size()) {
+        throw std::out_of_range("Graph node does not exist");
+    }
+}
+
+template<Arithmetic ComponentType>
+typename Graph<ComponentType>::NodeId Graph<ComponentType>::input(const Tensor<ComponentType> &tensor) {
+    return record({GraphOp::Input, {}, tensor.shape(), 0, &tensor});
+}
+
+template<Arithmetic ComponentType>
+typename Graph<ComponentType>::NodeId Graph<ComponentType>::matvec(NodeId mat, NodeId vec) {
+    checkNode(mat);
+    checkNode(vec);
+    const auto &m = _nodes[mat].shape;
+    const auto &v = _nodes[vec].shape;
+    if (m.size() != 2 || v.size() != 1 || m[1] != v[0]) {
+        throw std::invalid_argument("matvec: shapes do not match");
+    }
+    return record({GraphOp::MatVec, {mat, vec}, {m[0]}, 0, nullptr});
+}
+
+template<Arithmetic ComponentType>
+typename Graph<ComponentType>::NodeId Graph<ComponentType>::matmul(NodeId lhs, NodeId rhs) {
+    checkNode(lhs);
+    checkNode(rhs);
+    const auto &a = _nodes[lhs].shape;
+    const auto &b = _nodes[rhs].shape;
+    if (a.size() != 2 || b.size() != 2 || a[1] != b[0]) {
+        throw std::invalid_argument("matmul: shapes do not match");
+    }
+    return record({GraphOp::MatMul, {lhs, rhs}, {a[0], b[1]}, 0, nullptr});
+}
+
+template<Arithmetic ComponentType>
+typename Graph<ComponentType>::NodeId Graph<ComponentType>::add(NodeId lhs, NodeId rhs) {
+    checkNode(lhs);
+    checkNode(rhs);
+    if (_nodes[lhs].shape != _nodes[rhs].shape) {
+        throw std::invalid_argument("add: shapes do not match");
+    }
+    return record({GraphOp::Add, {lhs, rhs}, _nodes[lhs].shape, 0, nullptr});
+}
+
+template<Arithmetic ComponentType>
+typename Graph<ComponentType>::NodeId Graph<ComponentType>::mul(NodeId lhs, NodeId rhs) {
+    checkNode(lhs);
+    checkNode(rhs);
+    if (_nodes[lhs].shape != _nodes[rhs].shape) {
+        throw std::invalid_argument("mul: shapes do not match");
+    }
+    return record({GraphOp::Mul, {lhs, rhs}, _nodes[lhs].shape, 0, nullptr});
+}
+
+template<Arithmetic ComponentType>
+typename Graph<ComponentType>::NodeId Graph<ComponentType>::scale(NodeId node, const ComponentType &factor) {
+    checkNode(node);
+    return record({GraphOp::Scale, {node}, _nodes[node].shape, factor, nullptr});
+}
+
+template<Arithmetic ComponentType>
+typename Graph<ComponentType>::NodeId Graph<ComponentType>::relu(NodeId node) {
+    checkNode(node);
+    return record({GraphOp::Relu, {node}, _nodes[node].shape, 0, nullptr});
+}
+
+template<Arithmetic ComponentType>
+std::vector<size_t> Graph<ComponentType>::shape(NodeId node) const {
+    checkNode(node);
+    return _nodes[node].shape;
+}
+
+template<Arithmetic ComponentType>
+bool Graph<ComponentType>::isElementwise(GraphOp op) noexcept {
+    return op == GraphOp::Add || op == GraphOp::Mul || op == GraphOp::Scale || op == GraphOp::Relu;
+}
+
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Compilation
+/////////////////////////////////////////////
+
+template<Arithmetic ComponentType>
+void Graph<ComponentType>::compile(const std::vector<NodeId> &outputs) {
+    for (NodeId out: outputs) {
+        checkNode(out);
+    }
+    _kernels.clear();
+    _outputs = outputs;
+
+    // only nodes reachable from an output are computed
+    std::vector<bool> needed(_nodes.size(), false);
+    std::vector<bool> is_output(_nodes.size(), false);
+    for (NodeId out: outputs) {
+        needed[out] = true;
+        is_output[out] = true;
+    }
+    for (size_t n = _nodes.size(); n-- > 0;) {
+        if (needed[n]) {
+            for (NodeId arg: _nodes[n].args) {
+                needed[arg] = true;
+            }
+        }
+    }
+
+    std::vector<size_t> consumers(_nodes.size(), 0);
+    for (size_t n = 0; n < _nodes.size(); ++n) {
+        if (needed[n]) {
+            for (NodeId arg: _nodes[n].args) {
+                ++consumers[arg];
+            }
+        }
+    }
+
+    // Node ids are topologically sorted, so a single forward sweep suffices. An elementwise op
+    // joins the kernel of its first operand if nobody else needs that value materialised.
+    constexpr size_t none = static_cast<size_t>(-1);
+    std::vector<size_t> kernel_of(_nodes.size(), none);
+    std::vector<Kernel> open;
+    _eager_bytes = 0;
+    for (size_t n = 0; n < _nodes.size(); ++n) {
+        Node &node = _nodes[n];
+        if (!needed[n] || node.op == GraphOp::Input) {
+            continue;
+        }
+        if (!is_output[n]) {
+            _eager_bytes += Tensor<ComponentType>::calc_size(node.shape) * sizeof(ComponentType);
+        }
+
+        auto fusable = [&](NodeId arg) {
+            return kernel_of[arg] != none && consumers[arg] == 1 && !is_output[arg]
+                   && open[kernel_of[arg]].nodes.back() == arg;
+        };
+        if (isElementwise(node.op)) {
+            // add and mul commute, so either operand may carry the chain
+            if (node.args.size() == 2 && !fusable(node.args[0]) && fusable(node.args[1])) {
+                std::swap(node.args[0], node.args[1]);
+            }
+            if (fusable(node.args[0])) {
+                kernel_of[n] = kernel_of[node.args[0]];
+                open[kernel_of[n]].nodes.push_back(n);
+                continue;
+            }
+        }
+        kernel_of[n] = open.size();
+        open.push_back({{n}, 0, false});
+    }
+
+    // A kernel's inputs come from kernels ending at a smaller node id, so ordering by the
+    // last node gives a valid execution order.
+    std::sort(open.begin(), open.end(), [](const Kernel &a, const Kernel &b) {
+        return a.nodes.back() < b.nodes.back();
+    });
+    for (size_t k = 0; k < open.size(); ++k) {
+        open[k].is_output = is_output[open[k].nodes.back()];
+        for (NodeId n: open[k].nodes) {
+            kernel_of[n] = k;
+        }
+    }
+
+    // Liveness: a result lives from its kernel to the last kernel reading it (inclusive).
+    std::vector<size_t> last_use(open.size());
+    for (size_t k = 0; k < open.size(); ++k) {
+        last_use[k] = k;
+        for (NodeId n: open[k].nodes) {
+            for (NodeId arg: _nodes[n].args) {
+                if (_nodes[arg].op != GraphOp::Input && kernel_of[arg] != k) {
+                    last_use[kernel_of[arg]] = std::max(last_use[kernel_of[arg]], k);
+                }
+            }
+        }
+    }
+
+    // Greedy placement, largest buffers first, at the lowest offset not overlapping any
+    // already placed buffer whose lifetime intersects. Offsets stay cache line aligned.
+    constexpr size_t align = std::max<size_t>(1, 64 / sizeof(ComponentType));
+    std::vector<size_t> order;
+    for (size_t k = 0; k < open.size(); ++k) {
+        if (!open[k].is_output) {
+            order.push_back(k);
+        }
+    }
+    auto bufferSize = [&](size_t k) {
+        return Tensor<ComponentType>::calc_size(_nodes[open[k].nodes.back()].shape);
+    };
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return bufferSize(a) > bufferSize(b);
+    });
+
+    size_t arena_size = 0;
+    std::vector<size_t> placed;
+    for (size_t k: order) {
+        std::vector<std::pair<size_t, size_t>> taken;
+        for (size_t p: placed) {
+            if (k <= last_use[p] && p <= last_use[k]) {
+                taken.push_back({open[p].offset, open[p].offset + bufferSize(p)});
+            }
+        }
+        std::sort(taken.begin(), taken.end());
+        size_t offset = 0;
+        for (auto [begin, end]: taken) {
+            if (offset + bufferSize(k) <= begin) {
+                break;
+            }
+            offset = std::max(offset, (end + align - 1) / align * align);
+        }
+        open[k].offset = offset;
+        arena_size = std::max(arena_size, offset + bufferSize(k));
+        placed.push_back(k);
+    }
+
+    _kernels = std::move(open);
+    _arena.assign(arena_size, 0);
+    _compiled = true;
+}
+
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Execution
+/////////////////////////////////////////////
+
+template<Arithmetic ComponentType>
+ComponentType Graph<ComponentType>::apply(const Node &node, ComponentType value, size_t idx,
+                                          const std::vector<const ComponentType *> &values) const {
+    switch (node.op) {
+        case GraphOp::Add:
+            return value + values[node.args[1]][idx];
+        case GraphOp::Mul:
+            return value * values[node.args[1]][idx];
+        case GraphOp::Scale:
+            return value * node.scalar;
+        case GraphOp::Relu:
+            return value > 0 ? value : ComponentType(0);
+        default:
+            throw std::logic_error("Not an elementwise op");
+    }
+}
+
+template<Arithmetic ComponentType>
+void Graph<ComponentType>::execute(const Kernel &kernel, ComponentType *dst,
+                                   const std::vector<const ComponentType *> &values) const {
+    const Node &root = _nodes[kernel.nodes.front()];
+    const size_t size = Tensor<ComponentType>::calc_size(_nodes[kernel.nodes.back()].shape);
+    auto epilogue = [&](ComponentType value, size_t idx) {
+        for (size_t e = 1; e < kernel.nodes.size(); ++e) {
+            value = apply(_nodes[kernel.nodes[e]], value, idx, values);
+        }
+        return value;
+    };
+
+    if (root.op == GraphOp::MatVec) {
+        const ComponentType *mat = values[root.args[0]];
+        const ComponentType *vec = values[root.args[1]];
+        const size_t cols = _nodes[root.args[0]].shape[1];
+        for (size_t i = 0; i < size; ++i) {
+            ComponentType acc = 0;
+            for (size_t j = 0; j < cols; ++j) {
+                acc += mat[i * cols + j] * vec[j];
+            }
+            dst[i] = epilogue(acc, i);
+        }
+    } else if (root.op == GraphOp::MatMul) {
+        const ComponentType *lhs = values[root.args[0]];
+        const ComponentType *rhs = values[root.args[1]];
+        const size_t rows = _nodes[root.args[0]].shape[0];
+        const size_t inner = _nodes[root.args[0]].shape[1];
+        const size_t cols = _nodes[root.args[1]].shape[1];
+        // i-k-j order streams through rhs rows, the epilogue runs while the row is in cache
+        for (size_t i = 0; i < rows; ++i) {
+            ComponentType *row = dst + i * cols;
+            std::fill(row, row + cols, ComponentType(0));
+            for (size_t k = 0; k < inner; ++k) {
+                const ComponentType a = lhs[i * inner + k];
+                const ComponentType *b = rhs + k * cols;
+                for (size_t j = 0; j < cols; ++j) {
+                    row[j] += a * b[j];
+                }
+            }
+            for (size_t j = 0; j < cols; ++j) {
+                row[j] = epilogue(row[j], i * cols + j);
+            }
+        }
+    } else {
+        const ComponentType *src = values[root.args[0]];
+        for (size_t i = 0; i < size; ++i) {
+            dst[i] = epilogue(apply(root, src[i], i, values), i);
+        }
+    }
+}
+
+template<Arithmetic ComponentType>
+std::vector<Tensor<ComponentType>> Graph<ComponentType>::run() {
+    if (!_compiled) {
+        throw std::logic_error("Graph has to be compiled before running");
+    }
+
+    std::vector<Tensor<ComponentType>> results;
+    results.reserve(_outputs.size());
+    for (NodeId out: _outputs) {
+        results.emplace_back(_nodes[out].shape);
+    }
+
+    std::vector<const ComponentType *> values(_nodes.size(), nullptr);
+    std::vector<ComponentType *> targets(_nodes.size(), nullptr);
+    for (size_t n = 0; n < _nodes.size(); ++n) {
+        if (_nodes[n].op == GraphOp::Input) {
+            values[n] = _nodes[n].leaf->data();
+        }
+    }
+    for (const Kernel &kernel: _kernels) {
+        targets[kernel.nodes.back()] = _arena.data() + kernel.offset;
+    }
+    for (size_t o = 0; o < _outputs.size(); ++o) {
+        targets[_outputs[o]] = results[o].data();
+    }
+
+    for (const Kernel &kernel: _kernels) {
+        const NodeId result = kernel.nodes.back();
+        execute(kernel, targets[result], values);
+        values[result] = targets[result];
+    }
+
+    // the same node may be requested twice, or be a leaf
+    for (size_t o = 0; o < _outputs.size(); ++o) {
+        if (values[_outputs[o]] != results[o].data()) {
+            std::copy(values[_outputs[o]], values[_outputs[o]] + results[o].numElements(), results[o].data());
+        }
+    }
+    return results;
+}
+
+template<Arithmetic ComponentType>
+std::vector<Tensor<ComponentType>> Graph<ComponentType>::runEager(const std::vector<NodeId> &outputs) const {
+    for (NodeId out: outputs) {
+        checkNode(out);
+    }
+    std::vector<Tensor<ComponentType>> storage(_nodes.size());
+    std::vector<const ComponentType *> values(_nodes.size(), nullptr);
+    for (size_t n = 0; n < _nodes.size(); ++n) {
+        if (_nodes[n].op == GraphOp::Input) {
+            values[n] = _nodes[n].leaf->data();
+            continue;
+        }
+        storage[n] = Tensor<ComponentType>(_nodes[n].shape);
+        execute({{n}, 0, false}, storage[n].data(), values);
+        values[n] = storage[n].data();
+    }
+
+    std::vector<Tensor<ComponentType>> results;
+    for (NodeId out: outputs) {
+        results.emplace_back(_nodes[out].shape);
+        std::copy(values[out], values[out] + results.back().numElements(), results.back().data());
+    }
+    return results;
+}
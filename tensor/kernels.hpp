@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+
+#include "matvec.hpp"
+#include "parallel.hpp"
+
+// Blocked and threaded matvec/matmul kernels working on the flat row-major Tensor storage.
+// Their blocking parameters are chosen by the autotuner (see autotune.hpp).
+
+struct KernelConfig {
+    // rows handled per work item, also the unit handed to a thread
+    size_t block_rows = 16;
+    // columns (matvec) or inner dimension (matmul) processed per sweep, keeps operands in cache
+    size_t block_cols = 1024;
+    // independent accumulators (matvec) or unrolled columns (matmul): 1, 2, 4 or 8
+    size_t unroll = 4;
+    size_t threads = 1;
+
+    bool operator==(const KernelConfig &) const = default;
+};
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// matvec
+/////////////////////////////////////////////
+
+template<Arithmetic ComponentType, size_t Unroll>
+void matvecRows(const ComponentType *mat, const ComponentType *vec, ComponentType *out,
+                size_t row_begin, size_t row_end, size_t cols, size_t block_cols) {
+    std::fill(out + row_begin, out + row_end, ComponentType(0));
+    for (size_t c0 = 0; c0 < cols; c0 += block_cols) {
+        const size_t c1 = std::min(cols, c0 + block_cols);
+        for (size_t row = row_begin; row < row_end; ++row) {
+            const ComponentType *r = mat + row * cols;
+            ComponentType acc[Unroll] = {};
+            size_t j = c0;
+            for (; j + Unroll <= c1; j += Unroll) {
+                for (size_t u = 0; u < Unroll; ++u) {
+                    acc[u] += r[j + u] * vec[j + u];
+                }
+            }
+            for (; j < c1; ++j) {
+                acc[0] += r[j] * vec[j];
+            }
+            ComponentType sum = 0;
+            for (size_t u = 0; u < Unroll; ++u) {
+                sum += acc[u];
+            }
+            out[row] += sum;
+        }
+    }
+}
+
+// out[rows] = mat[rows, cols] * vec[cols]
+template<Arithmetic ComponentType>
+void matvecKernel(const ComponentType *mat, const ComponentType *vec, ComponentType *out,
+                  size_t rows, size_t cols, const KernelConfig &config) {
+    const size_t block_cols = std::max<size_t>(1, config.block_cols);
+    parallelFor(0, rows, config.block_rows, config.threads, [&](size_t begin, size_t end) {
+        switch (config.unroll) {
+            case 1: matvecRows<ComponentType, 1>(mat, vec, out, begin, end, cols, block_cols); break;
+            case 2: matvecRows<ComponentType, 2>(mat, vec, out, begin, end, cols, block_cols); break;
+            case 8: matvecRows<ComponentType, 8>(mat, vec, out, begin, end, cols, block_cols); break;
+            default: matvecRows<ComponentType, 4>(mat, vec, out, begin, end, cols, block_cols); break;
+        }
+    });
+}
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// matmul
+/////////////////////////////////////////////
+
+template<Arithmetic ComponentType, size_t Unroll>
+void matmulRows(const ComponentType *lhs, const ComponentType *rhs, ComponentType *out,
+                size_t row_begin, size_t row_end, size_t inner, size_t cols, size_t block_inner) {
+    std::fill(out + row_begin * cols, out + row_end * cols, ComponentType(0));
+    // i-k-j order, blocked over k so the touched rhs rows stay in cache for the whole row block
+    for (size_t k0 = 0; k0 < inner; k0 += block_inner) {
+        const size_t k1 = std::min(inner, k0 + block_inner);
+        for (size_t i = row_begin; i < row_end; ++i) {
+            ComponentType *c = out + i * cols;
+            for (size_t k = k0; k < k1; ++k) {
+                const ComponentType a = lhs[i * inner + k];
+                const ComponentType *b = rhs + k * cols;
+                size_t j = 0;
+                for (; j + Unroll <= cols; j += Unroll) {
+                    for (size_t u = 0; u < Unroll; ++u) {
+                        c[j + u] += a * b[j + u];
+                    }
+                }
+                for (; j < cols; ++j) {
+                    c[j] += a * b[j];
+                }
+            }
+        }
+    }
+}
+
+// out[rows, cols] = lhs[rows, inner] * rhs[inner, cols]
+template<Arithmetic ComponentType>
+void matmulKernel(const ComponentType *lhs, const ComponentType *rhs, ComponentType *out,
+                  size_t rows, size_t inner, size_t cols, const KernelConfig &config) {
+    const size_t block_inner = std::max<size_t>(1, config.block_cols);
+    parallelFor(0, rows, config.block_rows, config.threads, [&](size_t begin, size_t end) {
+        switch (config.unroll) {
+            case 1: matmulRows<ComponentType, 1>(lhs, rhs, out, begin, end, inner, cols, block_inner); break;
+            case 2: matmulRows<ComponentType, 2>(lhs, rhs, out, begin, end, inner, cols, block_inner); break;
+            case 8: matmulRows<ComponentType, 8>(lhs, rhs, out, begin, end, inner, cols, block_inner); break;
+            default: matmulRows<ComponentType, 4>(lhs, rhs, out, begin, end, inner, cols, block_inner); break;
+        }
+    });
+}
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Matrix / Vector front ends
+/////////////////////////////////////////////
+
+// Performs a matrix-vector multiplication with the given kernel configuration.
+template<Arithmetic ComponentType>
+Vector<ComponentType> matvec(const Matrix<ComponentType> &mat, const Vector<ComponentType> &vec,
+                             const KernelConfig &config) {
+    if (mat.cols() != vec.size()) {
+        throw std::invalid_argument("matvec: shapes do not match");
+    }
+    Vector<ComponentType> result(mat.rows());
+    matvecKernel(mat.tensor().data(), vec.tensor().data(), result.tensor().data(), mat.rows(), mat.cols(), config);
+    return result;
+}
+
+// Performs a matrix-matrix multiplication with the given kernel configuration.
+template<Arithmetic ComponentType>
+Matrix<ComponentType> matmul(const Matrix<ComponentType> &lhs, const Matrix<ComponentType> &rhs,
+                             const KernelConfig &config) {
+    if (lhs.cols() != rhs.rows()) {
+        throw std::invalid_argument("matmul: shapes do not match");
+    }
+    Matrix<ComponentType> result(lhs.rows(), rhs.cols());
+    matmulKernel(lhs.tensor().data(), rhs.tensor().data(), result.tensor().data(),
+                 lhs.rows(), lhs.cols(), rhs.cols(), config);
+    return result;
+}
@@ -27,6 +27,7 @@ public:
 
     // Reference to internal tensor.
     Tensor<ComponentType> &tensor();
+    const Tensor<ComponentType> &tensor() const;
 
 private:
     Tensor<ComponentType> tensor_;
@@ -60,6 +61,7 @@ public:
 
     // Reference to internal tensor.
     Tensor<ComponentType> &tensor();
+    const Tensor<ComponentType> &tensor() const;
 
 private:
     Tensor<ComponentType> tensor_;
@@ -97,6 +99,11 @@ Tensor<ComponentType> &Vector<ComponentType>::tensor() {
     return tensor_;
 }
 
+template<typename ComponentType>
+const Tensor<ComponentType> &Vector<ComponentType>::tensor() const {
+    return tensor_;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////// matrix
 ////////////////////////////////////////////////////////////////////////////////
@@ -133,6 +140,11 @@ Tensor<ComponentType> &Matrix<ComponentType>::tensor() {
     return tensor_;
 }
 
+template<typename ComponentType>
+const Tensor<ComponentType> &Matrix<ComponentType>::tensor() const {
+    return tensor_;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Performs a matrix-vector multiplication.
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef ADVPT_HAVE_LIBNUMA
+#include <numa.h>
+#include <numaif.h>
+#include <unistd.h>
+#endif
+
+#include "parallel.hpp"
+#include "tensor.hpp"
+
+// NUMA placement of tensor storage.
+// Pages of an existing buffer are migrated according to a policy, so a tensor that was
+// first-touched by a single thread can be spread over the sockets afterwards. Without libnuma
+// (ADVPT_HAVE_LIBNUMA) or on a single-node machine all of this degrades to no-ops.
+
+enum class NumaPolicy {
+    // leave pages where they were first touched
+    Default,
+    // round robin over all nodes, for data every thread reads
+    Interleave,
+    // each part of the static schedule on the node of the worker processing it, needs pinned
+    // workers since unpinned ones have no node and pull chunks dynamically
+    Partitioned
+};
+
+// True if the kernel supports NUMA and the machine has more than one node.
+inline bool numaEnabled() {
+#ifdef ADVPT_HAVE_LIBNUMA
+    return numa_available() >= 0 && numa_max_node() > 0;
+#else
+    return false;
+#endif
+}
+
+// Number of NUMA nodes, 1 if NUMA is not available.
+inline size_t numaNodes() {
+#ifdef ADVPT_HAVE_LIBNUMA
+    if (numa_available() >= 0) {
+        return static_cast<size_t>(numa_max_node()) + 1;
+    }
+#endif
+    return 1;
+}
+
+// Node the calling thread currently runs on.
+inline size_t currentNumaNode() {
+#ifdef ADVPT_HAVE_LIBNUMA
+    if (numaEnabled()) {
+        return static_cast<size_t>(std::max(0, numa_node_of_cpu(sched_getcpu())));
+    }
+#endif
+    return 0;
+}
+
+// Node the worker of parallelFor with the given index is pinned to.
+inline size_t numaNodeOfWorker(size_t worker, ThreadAffinity affinity) {
+#ifdef ADVPT_HAVE_LIBNUMA
+    if (numaEnabled() && affinity != ThreadAffinity::None) {
+        const std::vector<int> cpus = affinityCpus(affinity);
+        return static_cast<size_t>(std::max(0, numa_node_of_cpu(cpus[worker % cpus.size()])));
+    }
+#endif
+    (void) worker;
+    (void) affinity;
+    return 0;
+}
+
+// Migrates the pages covering [ptr, ptr + bytes) to node, or deals them round robin over all
+// nodes if node is negative. Pages move once and keep no memory policy, so later allocations
+// sharing a page are not bound to the node. Returns false if nothing was moved.
+inline bool numaMovePages(const void *ptr, size_t bytes, int node) {
+#ifdef ADVPT_HAVE_LIBNUMA
+    if (!numaEnabled() || bytes == 0) {
+        return false;
+    }
+    const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(ptr) / page * page;
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + bytes + page - 1) / page * page;
+
+    std::vector<int> targets;
+    if (node < 0) {
+        for (int n = 0; n <= numa_max_node(); ++n) {
+            if (numa_bitmask_isbitset(numa_all_nodes_ptr, static_cast<unsigned>(n))) targets.push_back(n);
+        }
+    } else {
+        targets.push_back(node);
+    }
+    const size_t count = (end - begin) / page;
+    std::vector<void *> pages(count);
+    std::vector<int> nodes(count);
+    std::vector<int> status(count);
+    for (size_t i = 0; i < count; ++i) {
+        pages[i] = reinterpret_cast<void *>(begin + i * page);
+        nodes[i] = targets[i % targets.size()];
+    }
+    // pages never touched report -ENOENT in status and are placed on first touch as usual
+    return numa_move_pages(0, static_cast<unsigned long>(count), pages.data(), nodes.data(), status.data(),
+                           MPOL_MF_MOVE) == 0;
+#else
+    (void) ptr;
+    (void) bytes;
+    (void) node;
+    return false;
+#endif
+}
+
+// Places the storage of tensor according to policy. For Partitioned the leading dimension is
+// split exactly like parallelFor(0, shape[0], grain, threads) splits it with the current
+// thread affinity, so kernels using the same grain read local memory. Without affinity there is
+// no static schedule to follow and Partitioned leaves the pages alone.
+template<Arithmetic ComponentType>
+bool placeTensor(const Tensor<ComponentType> &tensor, NumaPolicy policy, size_t threads = hardwareThreads(),
+                 size_t grain = 1) {
+    const size_t bytes = tensor.numElements() * sizeof(ComponentType);
+    switch (policy) {
+        case NumaPolicy::Interleave:
+            return numaMovePages(tensor.data(), bytes, -1);
+        case NumaPolicy::Partitioned: {
+            const ThreadAffinity affinity = threadAffinity();
+            if (tensor.rank() == 0 || !numaEnabled() || affinity == ThreadAffinity::None) {
+                return false;
+            }
+            const size_t rows = tensor.shape()[0];
+            const size_t row_bytes = rows == 0 ? 0 : bytes / rows;
+            // same clamping as parallelFor
+            grain = std::max<size_t>(1, grain);
+            threads = std::clamp<size_t>(threads, 1, std::max<size_t>(1, (rows + grain - 1) / grain));
+            bool moved = true;
+            for (size_t t = 0; t < threads; ++t) {
+                const auto [first, last] = staticRange(0, rows, grain, threads, t);
+                const auto node = static_cast<int>(numaNodeOfWorker(t, affinity));
+                moved &= numaMovePages(tensor.data() + first * (row_bytes / sizeof(ComponentType)),
+                                       (last - first) * row_bytes, node);
+            }
+            return moved;
+        }
+        default:
+            return false;
+    }
+}
+
+// Read-only data replicated once per NUMA node, e.g. weights every worker reads in full.
+// local() returns the copy on the node of the calling thread. On a single node there is
+// exactly one copy.
+template<Arithmetic ComponentType>
+class NumaReplicas {
+public:
+    explicit NumaReplicas(const Tensor<ComponentType> &tensor);
+
+    [[nodiscard]] size_t numReplicas() const {return _replicas.size();}
+
+    [[nodiscard]] const Tensor<ComponentType> &local() const {return replica(currentNumaNode());}
+
+    [[nodiscard]] const Tensor<ComponentType> &replica(size_t node) const {
+        return _replicas[node < _replicas.size() ? node : 0];
+    }
+
+private:
+    std::vector<Tensor<ComponentType>> _replicas;
+};
+
+template<Arithmetic ComponentType>
+NumaReplicas<ComponentType>::NumaReplicas(const Tensor<ComponentType> &tensor) {
+    const size_t nodes = numaEnabled() ? numaNodes() : 1;
+    _replicas.reserve(nodes);
+    for (size_t node = 0; node < nodes; ++node) {
+        _replicas.push_back(tensor);
+        numaMovePages(_replicas.back().data(), tensor.numElements() * sizeof(ComponentType), static_cast<int>(node));
+    }
+}
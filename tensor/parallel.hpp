@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#ifdef ADVPT_HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+// Number of hardware threads, at least one.
+inline size_t hardwareThreads() noexcept {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Where the workers of parallelFor run.
+// None leaves scheduling to the OS. Compact fills one NUMA node before the next, Spread
+// alternates between nodes. Pinned workers also get a static schedule, so worker t always
+// processes the same part of the range and memory placed for that part stays local.
+enum class ThreadAffinity {
+    None,
+    Compact,
+    Spread
+};
+
+inline std::atomic<ThreadAffinity> &threadAffinitySetting() {
+    static std::atomic<ThreadAffinity> affinity{ThreadAffinity::None};
+    return affinity;
+}
+
+inline void setThreadAffinity(ThreadAffinity affinity) {
+    threadAffinitySetting() = affinity;
+}
+
+inline ThreadAffinity threadAffinity() {
+    return threadAffinitySetting();
+}
+
+// CPUs this process may run on, ordered for the given affinity.
+inline std::vector<int> affinityCpus(ThreadAffinity affinity) {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        for (size_t cpu = 0; cpu < hardwareThreads(); ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    auto node = [](int cpu) {
+#ifdef ADVPT_HAVE_LIBNUMA
+        if (numa_available() >= 0) {
+            return std::max(0, numa_node_of_cpu(cpu));
+        }
+#endif
+        (void) cpu;
+        return 0;
+    };
+    // Compact: sorted by node. Spread: the i-th cpu of every node before the (i+1)-th of any.
+    std::stable_sort(cpus.begin(), cpus.end(), [&](int a, int b) {return node(a) < node(b);});
+    if (affinity == ThreadAffinity::Spread) {
+        std::vector<size_t> rank(cpus.size());
+        for (size_t i = 0, first = 0; i < cpus.size(); ++i) {
+            if (i > 0 && node(cpus[i]) != node(cpus[i - 1])) {
+                first = i;
+            }
+            rank[i] = i - first;
+        }
+        std::vector<size_t> order(cpus.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {return rank[a] < rank[b];});
+        std::vector<int> spread;
+        for (size_t i: order) spread.push_back(cpus[i]);
+        cpus = std::move(spread);
+    }
+    return cpus;
+}
+
+// Pins the calling thread to the cpu of the given worker index. Returns false if that is
+// not possible, the thread then simply keeps running unpinned.
+inline bool pinCurrentThread(size_t worker, ThreadAffinity affinity) {
+    if (affinity == ThreadAffinity::None) {
+        return false;
+    }
+#ifdef __linux__
+    static std::mutex mutex;
+    static std::vector<int> cpus[3];
+    std::vector<int> order;
+    {
+        std::lock_guard lock(mutex);
+        auto &cached = cpus[static_cast<size_t>(affinity)];
+        if (cached.empty()) {
+            cached = affinityCpus(affinity);
+        }
+        order = cached;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(order[worker % order.size()], &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void) worker;
+    return false;
+#endif
+}
+
+// Part of [begin, end) the static schedule assigns to worker out of threads, whole grains only.
+inline std::pair<size_t, size_t> staticRange(size_t begin, size_t end, size_t grain, size_t threads,
+                                             size_t worker) noexcept {
+    grain = std::max<size_t>(1, grain);
+    threads = std::max<size_t>(1, threads);
+    const size_t chunks = (end - begin + grain - 1) / grain;
+    const size_t first = chunks * worker / threads;
+    const size_t last = chunks * (worker + 1) / threads;
+    return {std::min(end, begin + first * grain), std::min(end, begin + last * grain)};
+}
+
+// Splits [begin, end) into chunks of grain elements and hands them to threads workers,
+// fn(chunk_begin, chunk_end) is called once per chunk. With one worker everything runs inline on
+// the calling thread, whatever the affinity. Unpinned workers pull chunks dynamically, pinned
+// workers take their staticRange.
+template<class Function>
+void parallelFor(size_t begin, size_t end, size_t grain, size_t threads, Function fn) {
+    if (begin >= end) {
+        return;
+    }
+    grain = std::max<size_t>(1, grain);
+    const size_t chunks = (end - begin + grain - 1) / grain;
+    threads = std::clamp<size_t>(threads, 1, chunks);
+    // a single worker always stays on the calling thread, pinned or not, so serial and nested
+    // calls neither spawn a thread nor pile up on the first cpu of the affinity list
+    if (threads == 1) {
+        fn(begin, end);
+        return;
+    }
+    const ThreadAffinity affinity = threadAffinity();
+
+    std::atomic<size_t> next{0};
+    auto worker = [&](size_t t) {
+        if (affinity != ThreadAffinity::None) {
+            pinCurrentThread(t, affinity);
+            const auto [first, last] = staticRange(begin, end, grain, threads, t);
+            for (size_t chunk_begin = first; chunk_begin < last; chunk_begin += grain) {
+                fn(chunk_begin, std::min(last, chunk_begin + grain));
+            }
+            return;
+        }
+        for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+            const size_t chunk_begin = begin + chunk * grain;
+            fn(chunk_begin, std::min(end, chunk_begin + grain));
+        }
+    };
+
+    // the calling thread only joins in unpinned, so its own affinity is never changed
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    const size_t first_spawned = affinity == ThreadAffinity::None ? 1 : 0;
+    for (size_t t = first_spawned; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    if (first_spawned == 1) {
+        worker(0);
+    }
+    for (auto &thread: pool) {
+        thread.join();
+    }
+}
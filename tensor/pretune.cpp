@@ -0,0 +1,55 @@
+#include <cmath>
+
+#include "autotune.hpp"
+
+// Tunes matvec and matmul for every dtype and shape class on this machine and writes the
+// winners to the tuning cache, so later runs start with tuned kernels.
+// Usage: pretune [threads] [cache_file]
+
+template<Arithmetic ComponentType>
+void tuneType(Autotuner &tuner, const std::vector<size_t> &thread_counts) {
+    // representative working sets, one per shape class
+    const std::vector<size_t> matvec_bytes = {size_t(16) << 10, size_t(512) << 10, size_t(16) << 20, size_t(64) << 20};
+    // matmul is only tuned up to class 2, the largest class reuses that entry
+    const std::vector<size_t> matmul_bytes = {size_t(16) << 10, size_t(512) << 10, size_t(4) << 20};
+
+    for (size_t threads: thread_counts) {
+        for (size_t bytes: matvec_bytes) {
+            const auto n = static_cast<size_t>(std::sqrt(bytes / sizeof(ComponentType)));
+            const KernelConfig c = tuner.tuneMatvec<ComponentType>(n, n, threads);
+            std::cout << "matvec " << dtypeName<ComponentType>() << " " << n << "x" << n << " threads " << threads
+                      << ": rows " << c.block_rows << ", cols " << c.block_cols << ", unroll " << c.unroll
+                      << ", threads " << c.threads << std::endl;
+        }
+        for (size_t bytes: matmul_bytes) {
+            const auto n = static_cast<size_t>(std::sqrt(bytes / (3 * sizeof(ComponentType))));
+            const KernelConfig c = tuner.tuneMatmul<ComponentType>(n, n, n, threads);
+            std::cout << "matmul " << dtypeName<ComponentType>() << " " << n << "x" << n << " threads " << threads
+                      << ": rows " << c.block_rows << ", inner " << c.block_cols << ", unroll " << c.unroll
+                      << ", threads " << c.threads << std::endl;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<size_t> thread_counts = {1};
+    if (argc > 1) {
+        thread_counts = {std::stoul(argv[1])};
+    } else if (hardwareThreads() > 1) {
+        thread_counts.push_back(hardwareThreads());
+    }
+    const std::string cache = argc > 2 ? argv[2] : Autotuner::defaultCachePath();
+
+    Autotuner tuner(cache, TuneMode::Cached);
+    std::cout << "CPU: " << cpuModel() << "\n" << "Cache: " << cache << std::endl;
+
+    tuneType<float>(tuner, thread_counts);
+    tuneType<double>(tuner, thread_counts);
+
+    if (!tuner.save()) {
+        std::cout << "Unable to write " << cache << std::endl;
+        return 1;
+    }
+    std::cout << tuner.numEntries() << " entries for this CPU written" << std::endl;
+    return 0;
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "parallel.hpp"
+#include "tensor.hpp"
+
+// Reductions along one axis of a tensor of any rank.
+// Around the reduced axis the tensor is seen as [outer, extent, inner]. Unless the reduced axis
+// is the last one, the innermost loop runs over a block of contiguous inner elements and adds
+// one slice after the other into it, so the input is read once in storage order. Reducing the
+// last axis works on contiguous rows with independent accumulators. Work is split into outer
+// slices and inner blocks handed to parallelFor.
+
+// inner elements accumulated per work item, small enough to stay in L1
+inline constexpr size_t reduce_block = 1024;
+// input elements per parallelFor chunk, keeps small reductions on the calling thread
+inline constexpr size_t reduce_chunk_elements = size_t(1) << 15;
+
+struct AxisSplit {
+    size_t outer = 1;
+    size_t extent = 1;
+    size_t inner = 1;
+};
+
+// Mean of integers is taken in double, floating point types keep their precision.
+template<Arithmetic ComponentType>
+using MeanType = std::conditional_t<std::is_floating_point_v<ComponentType>, ComponentType, double>;
+
+inline AxisSplit axisSplit(const std::vector<size_t> &shape, size_t axis) {
+    if (axis >= shape.size()) {
+        throw std::out_of_range("Axis out of range");
+    }
+    AxisSplit split;
+    for (size_t d = 0; d < axis; ++d) split.outer *= shape[d];
+    split.extent = shape[axis];
+    for (size_t d = axis + 1; d < shape.size(); ++d) split.inner *= shape[d];
+    return split;
+}
+
+// Shape after reducing axis, keepdims leaves it in place with extent 1 so the result broadcasts
+// against the input.
+inline std::vector<size_t> reducedShape(const std::vector<size_t> &shape, size_t axis, bool keepdims) {
+    std::vector<size_t> result = shape;
+    if (keepdims) {
+        result[axis] = 1;
+    } else {
+        result.erase(result.begin() + static_cast<std::ptrdiff_t>(axis));
+    }
+    return result;
+}
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Generic reduction
+/////////////////////////////////////////////
+
+// out[o, i] = combine(... combine(init, in[o, 0, i]) ..., in[o, extent - 1, i]), combine has to be
+// associative since the last axis is reduced with several accumulators.
+template<Arithmetic Result, Arithmetic ComponentType, class Combine>
+Tensor<Result> reduceAxis(const Tensor<ComponentType> &tensor, size_t axis, bool keepdims, size_t threads,
+                          Result init, Combine combine) {
+    const auto shape = tensor.shape();
+    const AxisSplit split = axisSplit(shape, axis);
+    Tensor<Result> result(reducedShape(shape, axis, keepdims), init);
+    const ComponentType *in = tensor.data();
+    Result *out = result.data();
+    if (split.extent == 0 || result.numElements() == 0) {
+        return result;
+    }
+
+    if (split.inner == 1) {
+        const size_t extent = split.extent;
+        const size_t grain = std::max<size_t>(1, reduce_chunk_elements / extent);
+        parallelFor(0, split.outer, grain, threads, [&](size_t begin, size_t end) {
+            for (size_t o = begin; o < end; ++o) {
+                const ComponentType *row = in + o * extent;
+                Result acc[4] = {init, init, init, init};
+                size_t k = 0;
+                for (; k + 4 <= extent; k += 4) {
+                    for (size_t u = 0; u < 4; ++u) {
+                        acc[u] = combine(acc[u], row[k + u]);
+                    }
+                }
+                for (; k < extent; ++k) {
+                    acc[0] = combine(acc[0], row[k]);
+                }
+                out[o] = combine(combine(acc[0], acc[1]), combine(acc[2], acc[3]));
+            }
+        });
+        return result;
+    }
+
+    const size_t blocks = (split.inner + reduce_block - 1) / reduce_block;
+    const size_t block_elements = split.extent * std::min(split.inner, reduce_block);
+    const size_t grain = std::max<size_t>(1, reduce_chunk_elements / block_elements);
+    parallelFor(0, split.outer * blocks, grain, threads, [&](size_t begin, size_t end) {
+        for (size_t item = begin; item < end; ++item) {
+            const size_t o = item / blocks;
+            const size_t j0 = (item % blocks) * reduce_block;
+            const size_t j1 = std::min(split.inner, j0 + reduce_block);
+            Result *acc = out + o * split.inner;
+            for (size_t k = 0; k < split.extent; ++k) {
+                const ComponentType *slice = in + (o * split.extent + k) * split.inner;
+                for (size_t j = j0; j < j1; ++j) {
+                    acc[j] = combine(acc[j], slice[j]);
+                }
+            }
+        }
+    });
+    return result;
+}
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// sum, mean, max, argmax
+/////////////////////////////////////////////
+
+template<Arithmetic ComponentType>
+Tensor<ComponentType> sum(const Tensor<ComponentType> &tensor, size_t axis, bool keepdims = false,
+                          size_t threads = hardwareThreads()) {
+    return reduceAxis<ComponentType>(tensor, axis, keepdims, threads, ComponentType(0),
+                                     [](ComponentType acc, ComponentType x) { return acc + x; });
+}
+
+template<Arithmetic ComponentType>
+Tensor<MeanType<ComponentType>> mean(const Tensor<ComponentType> &tensor, size_t axis, bool keepdims = false,
+                                     size_t threads = hardwareThreads()) {
+    using Result = MeanType<ComponentType>;
+    const size_t extent = axisSplit(tensor.shape(), axis).extent;
+    if (extent == 0) {
+        throw std::invalid_argument("mean: axis is empty");
+    }
+    auto result = reduceAxis<Result>(tensor, axis, keepdims, threads, Result(0),
+                                     [](Result acc, Result x) { return acc + x; });
+    const Result scale = Result(1) / static_cast<Result>(extent);
+    Result *out = result.data();
+    for (size_t i = 0; i < result.numElements(); ++i) {
+        out[i] *= scale;
+    }
+    return result;
+}
+
+template<Arithmetic ComponentType>
+Tensor<ComponentType> max(const Tensor<ComponentType> &tensor, size_t axis, bool keepdims = false,
+                          size_t threads = hardwareThreads()) {
+    if (axisSplit(tensor.shape(), axis).extent == 0) {
+        throw std::invalid_argument("max: axis is empty");
+    }
+    constexpr ComponentType lowest = std::numeric_limits<ComponentType>::has_infinity
+                                         ? -std::numeric_limits<ComponentType>::infinity()
+                                         : std::numeric_limits<ComponentType>::lowest();
+    // a select rather than std::max, it vectorises
+    return reduceAxis<ComponentType>(tensor, axis, keepdims, threads, lowest,
+                                     [](ComponentType acc, ComponentType x) { return x > acc ? x : acc; });
+}
+
+// Index of the largest element along axis, the first one on ties.
+template<Arithmetic ComponentType>
+Tensor<size_t> argmax(const Tensor<ComponentType> &tensor, size_t axis, bool keepdims = false,
+                      size_t threads = hardwareThreads()) {
+    const auto shape = tensor.shape();
+    const AxisSplit split = axisSplit(shape, axis);
+    if (split.extent == 0) {
+        throw std::invalid_argument("argmax: axis is empty");
+    }
+    Tensor<size_t> result(reducedShape(shape, axis, keepdims));
+    const ComponentType *in = tensor.data();
+    size_t *out = result.data();
+
+    if (split.inner == 1) {
+        const size_t grain = std::max<size_t>(1, reduce_chunk_elements / split.extent);
+        parallelFor(0, split.outer, grain, threads, [&](size_t begin, size_t end) {
+            for (size_t o = begin; o < end; ++o) {
+                const ComponentType *row = in + o * split.extent;
+                size_t index = 0;
+                for (size_t k = 1; k < split.extent; ++k) {
+                    if (row[k] > row[index]) index = k;
+                }
+                out[o] = index;
+            }
+        });
+        return result;
+    }
+
+    const size_t blocks = (split.inner + reduce_block - 1) / reduce_block;
+    const size_t block_elements = split.extent * std::min(split.inner, reduce_block);
+    const size_t grain = std::max<size_t>(1, reduce_chunk_elements / block_elements);
+    parallelFor(0, split.outer * blocks, grain, threads, [&](size_t begin, size_t end) {
+        ComponentType best[reduce_block];
+        for (size_t item = begin; item < end; ++item) {
+            const size_t o = item / blocks;
+            const size_t j0 = (item % blocks) * reduce_block;
+            const size_t n = std::min(split.inner, j0 + reduce_block) - j0;
+            const ComponentType *first = in + o * split.extent * split.inner + j0;
+            size_t *index = out + o * split.inner + j0;
+            std::copy(first, first + n, best);
+            std::fill(index, index + n, size_t(0));
+            for (size_t k = 1; k < split.extent; ++k) {
+                const ComponentType *slice = first + k * split.inner;
+                for (size_t j = 0; j < n; ++j) {
+                    const bool take = slice[j] > best[j];
+                    best[j] = take ? slice[j] : best[j];
+                    index[j] = take ? k : index[j];
+                }
+            }
+        }
+    });
+    return result;
+}
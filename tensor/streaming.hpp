@@ -0,0 +1,474 @@
+#pragma once
+
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <future>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ADVPT_HAVE_MMAP
+#endif
+
+#include "kernels.hpp"
+
+// Out-of-core matvec/matmul.
+// The left hand matrix stays on disk and is read in panels of whole rows, while the current
+// panel is multiplied the next one is already being read. Only two panels are ever resident,
+// so memory stays bounded no matter how large the matrix is.
+//
+// Matrices can be streamed from the text format of readTensorFromFile or from the binary
+// format below, which is either read into panel buffers or mmapped.
+//
+// Binary layout (native byte order):
+//   "ADVPTBIN"  uint16 element size  uint16 kind ('f', 'i' or 'u')  uint32 rank
+//   uint64 shape[rank]  zero padding up to the next multiple of 64 bytes  row-major data
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Binary format
+/////////////////////////////////////////////
+
+struct BinaryHeader {
+    size_t element_size = 0;
+    char kind = 0;
+    std::vector<size_t> shape;
+    size_t data_offset = 0;
+};
+
+inline constexpr char binaryMagic[8] = {'A', 'D', 'V', 'P', 'T', 'B', 'I', 'N'};
+
+template<Arithmetic ComponentType>
+constexpr char binaryKind() {
+    return std::is_floating_point_v<ComponentType> ? 'f' : std::is_signed_v<ComponentType> ? 'i' : 'u';
+}
+
+// True if the file starts with the binary magic.
+inline bool isBinaryTensorFile(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[8] = {};
+    file.read(magic, sizeof(magic));
+    return file.good() && std::memcmp(magic, binaryMagic, sizeof(magic)) == 0;
+}
+
+inline BinaryHeader readBinaryHeader(std::istream &in) {
+    char magic[8];
+    uint16_t element_size = 0;
+    uint16_t kind = 0;
+    uint32_t rank = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(&element_size), sizeof(element_size));
+    in.read(reinterpret_cast<char *>(&kind), sizeof(kind));
+    in.read(reinterpret_cast<char *>(&rank), sizeof(rank));
+    if (!in || std::memcmp(magic, binaryMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a binary tensor file");
+    }
+    BinaryHeader header;
+    header.element_size = element_size;
+    header.kind = static_cast<char>(kind);
+    header.shape.resize(rank);
+    for (size_t &extent: header.shape) {
+        uint64_t value = 0;
+        in.read(reinterpret_cast<char *>(&value), sizeof(value));
+        extent = static_cast<size_t>(value);
+    }
+    if (!in) {
+        throw std::runtime_error("Truncated binary tensor header");
+    }
+    header.data_offset = (16 + 8 * static_cast<size_t>(rank) + 63) / 64 * 64;
+    return header;
+}
+
+template<Arithmetic ComponentType>
+void writeBinaryHeader(std::ostream &out, const std::vector<size_t> &shape) {
+    const auto element_size = static_cast<uint16_t>(sizeof(ComponentType));
+    const auto kind = static_cast<uint16_t>(binaryKind<ComponentType>());
+    const auto rank = static_cast<uint32_t>(shape.size());
+    out.write(binaryMagic, sizeof(binaryMagic));
+    out.write(reinterpret_cast<const char *>(&element_size), sizeof(element_size));
+    out.write(reinterpret_cast<const char *>(&kind), sizeof(kind));
+    out.write(reinterpret_cast<const char *>(&rank), sizeof(rank));
+    for (size_t extent: shape) {
+        const auto value = static_cast<uint64_t>(extent);
+        out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    const size_t written = 16 + 8 * shape.size();
+    const std::vector<char> padding((written + 63) / 64 * 64 - written, 0);
+    out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+}
+
+// Writes a tensor in the binary format.
+template<Arithmetic ComponentType>
+void writeTensorToBinaryFile(const Tensor<ComponentType> &tensor, const std::string &filename) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    writeBinaryHeader<ComponentType>(file, tensor.shape());
+    file.write(reinterpret_cast<const char *>(tensor.data()),
+               static_cast<std::streamsize>(tensor.numElements() * sizeof(ComponentType)));
+}
+
+// Reads a whole tensor from the binary format.
+template<Arithmetic ComponentType>
+Tensor<ComponentType> readTensorFromBinaryFile(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    const BinaryHeader header = readBinaryHeader(file);
+    if (header.element_size != sizeof(ComponentType) || header.kind != binaryKind<ComponentType>()) {
+        throw std::runtime_error("Binary tensor file holds a different component type");
+    }
+    Tensor<ComponentType> tensor(header.shape);
+    file.seekg(static_cast<std::streamoff>(header.data_offset));
+    file.read(reinterpret_cast<char *>(tensor.data()),
+              static_cast<std::streamsize>(tensor.numElements() * sizeof(ComponentType)));
+    if (!file) {
+        throw std::runtime_error("Truncated binary tensor file: " + filename);
+    }
+    return tensor;
+}
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Panel sources
+/////////////////////////////////////////////
+
+// Each source hands out consecutive panels of whole rows of a rank 2 tensor:
+// next(buffer, max_rows) returns a pointer to the rows and how many there are (0 at the end).
+// The pointer is either buffer or, for mmap, points into the mapping; it stays valid until
+// next() has been called twice more. needsBuffer() is false if buffer is never written.
+
+// Parses the text format chunk by chunk. The chunk grows if a single number does not fit.
+template<Arithmetic ComponentType>
+class TextPanelSource {
+public:
+    explicit TextPanelSource(const std::string &filename, size_t chunk_bytes = size_t(1) << 20);
+
+    [[nodiscard]] size_t rows() const {return _shape[0];}
+    [[nodiscard]] size_t cols() const {return _shape[1];}
+
+    [[nodiscard]] bool needsBuffer() const {return true;}
+
+    std::pair<const ComponentType *, size_t> next(ComponentType *buffer, size_t max_rows);
+
+private:
+    std::ifstream _file;
+    std::vector<size_t> _shape;
+    size_t _row = 0;
+    std::vector<char> _chunk;
+    size_t _pos = 0;
+    size_t _end = 0;
+
+    // skips whitespace, refills the chunk if needed; false at the end of the file
+    bool fill();
+};
+
+template<Arithmetic ComponentType>
+TextPanelSource<ComponentType>::TextPanelSource(const std::string &filename, size_t chunk_bytes) :
+    _file(filename),
+    _chunk(std::max<size_t>(1, chunk_bytes)) {
+    if (!_file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    std::string line;
+    getline(_file, line);
+    const size_t rank = std::stoul(line);
+    for (size_t i = 0; i < rank; ++i) {
+        getline(_file, line);
+        _shape.push_back(std::stoul(line));
+    }
+    if (rank != 2) {
+        throw std::runtime_error("Only matrices can be streamed: " + filename);
+    }
+}
+
+template<Arithmetic ComponentType>
+bool TextPanelSource<ComponentType>::fill() {
+    while (true) {
+        while (_pos < _end && std::isspace(static_cast<unsigned char>(_chunk[_pos]))) {
+            ++_pos;
+        }
+        // a number must not be cut at the chunk end, keep at least one full token buffered
+        const auto token_end = std::find_if(_chunk.begin() + static_cast<std::ptrdiff_t>(_pos),
+                                            _chunk.begin() + static_cast<std::ptrdiff_t>(_end),
+                                            [](char ch) {return std::isspace(static_cast<unsigned char>(ch));});
+        if (_pos < _end && (token_end != _chunk.begin() + static_cast<std::ptrdiff_t>(_end) || _file.eof())) {
+            return true;
+        }
+        if (_file.eof()) {
+            return false;
+        }
+        std::memmove(_chunk.data(), _chunk.data() + _pos, _end - _pos);
+        _end -= _pos;
+        _pos = 0;
+        if (_end == _chunk.size()) {
+            _chunk.resize(2 * _chunk.size());
+        }
+        _file.read(_chunk.data() + _end, static_cast<std::streamsize>(_chunk.size() - _end));
+        _end += static_cast<size_t>(_file.gcount());
+    }
+}
+
+template<Arithmetic ComponentType>
+std::pair<const ComponentType *, size_t> TextPanelSource<ComponentType>::next(ComponentType *buffer,
+                                                                              size_t max_rows) {
+    const size_t count = std::min(max_rows, rows() - _row);
+    for (size_t i = 0; i < count * cols(); ++i) {
+        if (!fill()) {
+            throw std::runtime_error("Text tensor file ends early");
+        }
+        // values like 2.0 in an integer file are read as double first, just like readTensorFromFile
+        ComponentType value{};
+        auto [ptr, ec] = std::from_chars(_chunk.data() + _pos, _chunk.data() + _end, value);
+        if (ec != std::errc() || (ptr < _chunk.data() + _end && !std::isspace(static_cast<unsigned char>(*ptr)))) {
+            double fallback = 0;
+            const auto parsed = std::from_chars(_chunk.data() + _pos, _chunk.data() + _end, fallback);
+            ptr = parsed.ptr;
+            if (parsed.ec != std::errc()) {
+                throw std::runtime_error("Invalid number in text tensor file");
+            }
+            value = static_cast<ComponentType>(fallback);
+        }
+        buffer[i] = value;
+        _pos = static_cast<size_t>(ptr - _chunk.data());
+    }
+    _row += count;
+    return {buffer, count};
+}
+
+// Reads panels of the binary format, by plain reads or through a read-only mapping.
+template<Arithmetic ComponentType>
+class BinaryPanelSource {
+public:
+    BinaryPanelSource(const std::string &filename, bool use_mmap = false);
+
+    ~BinaryPanelSource();
+
+    BinaryPanelSource(const BinaryPanelSource &) = delete;
+    BinaryPanelSource &operator=(const BinaryPanelSource &) = delete;
+
+    [[nodiscard]] size_t rows() const {return _header.shape[0];}
+    [[nodiscard]] size_t cols() const {return _header.shape[1];}
+
+    // mapped panels are used in place
+    [[nodiscard]] bool needsBuffer() const {return _map == nullptr;}
+
+    std::pair<const ComponentType *, size_t> next(ComponentType *buffer, size_t max_rows);
+
+private:
+    std::ifstream _file;
+    BinaryHeader _header;
+    size_t _row = 0;
+    // mmap state: the mapping and the rows handed out by the previous two calls
+    void *_map = nullptr;
+    size_t _map_size = 0;
+    std::pair<size_t, size_t> _previous[2] = {};
+
+    void release(std::pair<size_t, size_t> panel) const;
+};
+
+template<Arithmetic ComponentType>
+BinaryPanelSource<ComponentType>::BinaryPanelSource(const std::string &filename, bool use_mmap) :
+    _file(filename, std::ios::binary) {
+    if (!_file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    _header = readBinaryHeader(_file);
+    if (_header.shape.size() != 2) {
+        throw std::runtime_error("Only matrices can be streamed: " + filename);
+    }
+    if (_header.element_size != sizeof(ComponentType) || _header.kind != binaryKind<ComponentType>()) {
+        throw std::runtime_error("Binary tensor file holds a different component type");
+    }
+    _file.seekg(static_cast<std::streamoff>(_header.data_offset));
+#ifdef ADVPT_HAVE_MMAP
+    if (use_mmap && rows() * cols() > 0) {
+        const int fd = open(filename.c_str(), O_RDONLY);
+        _map_size = _header.data_offset + rows() * cols() * sizeof(ComponentType);
+        if (fd >= 0) {
+            // pages past the end of a truncated file raise SIGBUS when read, fail like the read path
+            struct stat st{};
+            if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) < _map_size) {
+                close(fd);
+                throw std::runtime_error("Binary tensor file ends early");
+            }
+            _map = mmap(nullptr, _map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+        }
+        if (_map == MAP_FAILED || fd < 0) {
+            _map = nullptr;
+        } else {
+            madvise(_map, _map_size, MADV_SEQUENTIAL);
+        }
+    }
+#else
+    (void) use_mmap;
+#endif
+}
+
+template<Arithmetic ComponentType>
+BinaryPanelSource<ComponentType>::~BinaryPanelSource() {
+#ifdef ADVPT_HAVE_MMAP
+    if (_map != nullptr) {
+        munmap(_map, _map_size);
+    }
+#endif
+}
+
+// Drops the pages of a consumed panel, they are clean file pages and can simply be reread.
+template<Arithmetic ComponentType>
+void BinaryPanelSource<ComponentType>::release(std::pair<size_t, size_t> panel) const {
+#ifdef ADVPT_HAVE_MMAP
+    const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t row_bytes = cols() * sizeof(ComponentType);
+    // only whole pages inside the panel, the neighbours may still be in use
+    const size_t begin = (_header.data_offset + panel.first * row_bytes + page - 1) / page * page;
+    const size_t end = (_header.data_offset + (panel.first + panel.second) * row_bytes) / page * page;
+    if (end > begin) {
+        madvise(static_cast<char *>(_map) + begin, end - begin, MADV_DONTNEED);
+    }
+#else
+    (void) panel;
+#endif
+}
+
+template<Arithmetic ComponentType>
+std::pair<const ComponentType *, size_t> BinaryPanelSource<ComponentType>::next(ComponentType *buffer,
+                                                                                size_t max_rows) {
+    const size_t count = std::min(max_rows, rows() - _row);
+    const size_t first = _row;
+    _row += count;
+    if (count == 0) {
+        return {buffer, 0};
+    }
+#ifdef ADVPT_HAVE_MMAP
+    if (_map != nullptr) {
+        release(_previous[0]);
+        _previous[0] = _previous[1];
+        _previous[1] = {first, count};
+        const char *data = static_cast<const char *>(_map) + _header.data_offset;
+        const ComponentType *panel = reinterpret_cast<const ComponentType *>(data) + first * cols();
+        // start reading ahead, the kernel will touch the whole panel anyway
+        const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const auto address = reinterpret_cast<uintptr_t>(panel);
+        madvise(reinterpret_cast<void *>(address / page * page),
+                address % page + count * cols() * sizeof(ComponentType), MADV_WILLNEED);
+        return {panel, count};
+    }
+#endif
+    _file.read(reinterpret_cast<char *>(buffer), static_cast<std::streamsize>(count * cols() * sizeof(ComponentType)));
+    if (!_file) {
+        throw std::runtime_error("Binary tensor file ends early");
+    }
+    return {buffer, count};
+}
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Streaming kernels
+/////////////////////////////////////////////
+
+struct StreamConfig {
+    // rows per panel, 0 derives them from memory_budget
+    size_t panel_rows = 0;
+    // bytes for the two panel buffers together
+    size_t memory_budget = size_t(64) << 20;
+    // binary files only: map the file instead of reading into buffers
+    bool use_mmap = false;
+    KernelConfig kernel = {16, 4096, 4, hardwareThreads()};
+};
+
+// Calls fn(panel, first_row, rows) for all panels of source in order. Reading panel k + 1
+// runs asynchronously while fn works on panel k.
+template<Arithmetic ComponentType, class Source, class Function>
+void streamPanels(Source &source, const StreamConfig &config, Function fn) {
+    const size_t row_bytes = std::max<size_t>(1, source.cols() * sizeof(ComponentType));
+    const size_t panel_rows = config.panel_rows > 0 ? config.panel_rows
+                                                    : std::max<size_t>(1, config.memory_budget / (2 * row_bytes));
+    std::vector<ComponentType> buffers[2];
+    if (source.needsBuffer()) {
+        buffers[0].resize(panel_rows * source.cols());
+        buffers[1].resize(panel_rows * source.cols());
+    }
+
+    auto fetch = [&](size_t b) {return source.next(buffers[b].data(), panel_rows);};
+    auto pending = std::async(std::launch::async, fetch, 0);
+    size_t row = 0;
+    for (size_t current = 0;; current = 1 - current) {
+        const auto [panel, count] = pending.get();
+        if (count == 0) {
+            break;
+        }
+        pending = std::async(std::launch::async, fetch, 1 - current);
+        fn(panel, row, count);
+        row += count;
+    }
+}
+
+// Opens the matching panel source for a text or binary file and passes it to fn.
+template<Arithmetic ComponentType, class Function>
+void withMatrixSource(const std::string &filename, const StreamConfig &config, Function fn) {
+    if (isBinaryTensorFile(filename)) {
+        BinaryPanelSource<ComponentType> source(filename, config.use_mmap);
+        fn(source);
+    } else {
+        TextPanelSource<ComponentType> source(filename);
+        fn(source);
+    }
+}
+
+// Matrix-vector multiplication with the matrix streamed from a text or binary file.
+template<Arithmetic ComponentType>
+Vector<ComponentType> streamingMatvec(const std::string &filename, const Vector<ComponentType> &vec,
+                                      const StreamConfig &config = {}) {
+    Vector<ComponentType> result;
+    withMatrixSource<ComponentType>(filename, config, [&](auto &source) {
+        if (source.cols() != vec.size()) {
+            throw std::invalid_argument("streamingMatvec: shapes do not match");
+        }
+        result = Vector<ComponentType>(source.rows());
+        ComponentType *out = result.tensor().data();
+        streamPanels<ComponentType>(source, config, [&](const ComponentType *panel, size_t first, size_t count) {
+            matvecKernel(panel, vec.tensor().data(), out + first, count, source.cols(), config.kernel);
+        });
+    });
+    return result;
+}
+
+// Matrix-matrix multiplication with the left matrix streamed from a text or binary file.
+template<Arithmetic ComponentType>
+Matrix<ComponentType> streamingMatmul(const std::string &filename, const Matrix<ComponentType> &rhs,
+                                      const StreamConfig &config = {}) {
+    Matrix<ComponentType> result;
+    withMatrixSource<ComponentType>(filename, config, [&](auto &source) {
+        if (source.cols() != rhs.rows()) {
+            throw std::invalid_argument("streamingMatmul: shapes do not match");
+        }
+        result = Matrix<ComponentType>(source.rows(), rhs.cols());
+        ComponentType *out = result.tensor().data();
+        streamPanels<ComponentType>(source, config, [&](const ComponentType *panel, size_t first, size_t count) {
+            matmulKernel(panel, rhs.tensor().data(), out + first * rhs.cols(), count, source.cols(), rhs.cols(),
+                         config.kernel);
+        });
+    });
+    return result;
+}
+
+// Converts a text tensor file of rank 2 to the binary format panel by panel.
+template<Arithmetic ComponentType>
+void convertTextToBinary(const std::string &text_file, const std::string &binary_file,
+                         const StreamConfig &config = {}) {
+    TextPanelSource<ComponentType> source(text_file);
+    std::ofstream out(binary_file, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open file: " + binary_file);
+    }
+    writeBinaryHeader<ComponentType>(out, {source.rows(), source.cols()});
+    streamPanels<ComponentType>(source, config, [&](const ComponentType *panel, size_t, size_t count) {
+        out.write(reinterpret_cast<const char *>(panel),
+                  static_cast<std::streamsize>(count * source.cols() * sizeof(ComponentType)));
+    });
+}
@@ -64,6 +64,10 @@ public:
     ComponentType &Flat_idx(const size_t idx);
     const ComponentType &Flat_idx (const size_t idx) const;
 
+    // Raw pointer to the flattened storage (last index fastest), used by the compute kernels
+    ComponentType *data() noexcept {return _data.data();}
+    const ComponentType *data() const noexcept {return _data.data();}
+
 private:
     // TODO: Probably you need some members here...
     std::vector<size_t> _tensor_shape;
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <type_traits>
+
+#include "tensor.hpp"
+
+// Non-owning view of strided storage with Tensor's indexing.
+// Used to hand memory owned elsewhere (another Tensor, an Eigen matrix, a mapped file) to code
+// written against tensors without copying. Strides are given in elements, the default is
+// row-major like Tensor. Use TensorView<const T> for read-only access.
+template<Arithmetic ComponentType>
+class TensorView {
+public:
+    using ValueType = std::remove_const_t<ComponentType>;
+
+    // Contiguous row-major view.
+    TensorView(ComponentType *data, const std::vector<size_t> &shape);
+
+    TensorView(ComponentType *data, const std::vector<size_t> &shape, const std::vector<size_t> &strides);
+
+    // Views of a whole tensor.
+    TensorView(Tensor<ValueType> &tensor);
+
+    TensorView(const Tensor<ValueType> &tensor) requires std::is_const_v<ComponentType>;
+
+    [[nodiscard]] size_t rank() const {return _shape.size();}
+
+    [[nodiscard]] const std::vector<size_t> &shape() const {return _shape;}
+
+    [[nodiscard]] const std::vector<size_t> &strides() const {return _strides;}
+
+    [[nodiscard]] size_t numElements() const {return Tensor<ValueType>::calc_size(_shape);}
+
+    [[nodiscard]] ComponentType *data() const noexcept {return _data;}
+
+    // True if the elements are laid out exactly like a Tensor of the same shape.
+    [[nodiscard]] bool isContiguous() const;
+
+    // Element access, same checks as Tensor.
+    ComponentType &operator()(const std::vector<size_t> &idx) const;
+
+    // Copies the viewed elements into an owning tensor.
+    [[nodiscard]] Tensor<ValueType> toTensor() const;
+
+private:
+    ComponentType *_data;
+    std::vector<size_t> _shape;
+    std::vector<size_t> _strides;
+
+    static std::vector<size_t> rowMajorStrides(const std::vector<size_t> &shape);
+};
+
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Constructors
+/////////////////////////////////////////////
+
+template<Arithmetic ComponentType>
+TensorView<ComponentType>::TensorView(ComponentType *data, const std::vector<size_t> &shape) :
+    _data(data),
+    _shape(shape),
+    _strides(rowMajorStrides(shape)) {
+}
+
+template<Arithmetic ComponentType>
+TensorView<ComponentType>::TensorView(ComponentType *data, const std::vector<size_t> &shape,
+                                      const std::vector<size_t> &strides) :
+    _data(data),
+    _shape(shape),
+    _strides(strides) {
+    if (_strides.size() != _shape.size()) {
+        throw std::invalid_argument("Number of strides does not match rank");
+    }
+}
+
+template<Arithmetic ComponentType>
+TensorView<ComponentType>::TensorView(Tensor<ValueType> &tensor) :
+    TensorView(tensor.data(), tensor.shape()) {
+}
+
+template<Arithmetic ComponentType>
+TensorView<ComponentType>::TensorView(const Tensor<ValueType> &tensor) requires std::is_const_v<ComponentType> :
+    TensorView(tensor.data(), tensor.shape()) {
+}
+
+template<Arithmetic ComponentType>
+std::vector<size_t> TensorView<ComponentType>::rowMajorStrides(const std::vector<size_t> &shape) {
+    std::vector<size_t> strides(shape.size());
+    size_t stride = 1;
+    for (size_t i = shape.size(); i-- > 0;) {
+        strides[i] = stride;
+        stride *= shape[i];
+    }
+    return strides;
+}
+
+/////////////////////////////////////////////
+///////////////////////////////////////////// Access
+/////////////////////////////////////////////
+
+template<Arithmetic ComponentType>
+bool TensorView<ComponentType>::isContiguous() const {
+    const auto expected = rowMajorStrides(_shape);
+    for (size_t i = 0; i < _shape.size(); ++i) {
+        // strides of extent 1 dimensions never matter
+        if (_shape[i] != 1 && _strides[i] != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<Arithmetic ComponentType>
+ComponentType &TensorView<ComponentType>::operator()(const std::vector<size_t> &idx) const {
+    if (idx.size() != _shape.size()) {
+        throw std::out_of_range("Index size does not match tensor rank");
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < idx.size(); ++i) {
+        if (idx[i] >= _shape[i]) {
+            throw std::out_of_range("Index out of bounds");
+        }
+        offset += idx[i] * _strides[i];
+    }
+    return _data[offset];
+}
+
+template<Arithmetic ComponentType>
+Tensor<typename TensorView<ComponentType>::ValueType> TensorView<ComponentType>::toTensor() const {
+    Tensor<ValueType> result(_shape);
+    if (isContiguous()) {
+        std::copy(_data, _data + numElements(), result.data());
+        return result;
+    }
+    // walk the elements in row-major order, the last index fastest
+    std::vector<size_t> coord(_shape.size(), 0);
+    size_t offset = 0;
+    for (size_t flat = 0; flat < result.numElements(); ++flat) {
+        result.Flat_idx(flat) = _data[offset];
+        for (size_t d = _shape.size(); d-- > 0;) {
+            offset += _strides[d];
+            if (++coord[d] < _shape[d]) {
+                break;
+            }
+            offset -= coord[d] * _strides[d];
+            coord[d] = 0;
+        }
+    }
+    return result;
+}
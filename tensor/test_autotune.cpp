@@ -0,0 +1,124 @@
+#include <filesystem>
+
+#include "autotune.hpp"
+#include "kernels.hpp"
+#include "matvec.hpp"
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+void test_kernels(std::vector<std::pair<bool, std::string> > &results) {
+    Matrix<int> A("data/matrix");
+    Vector<int> x("data/vector_in");
+    Vector<int> y_read("data/vector_out");
+
+    bool all_equal = true;
+    for (size_t rows: {1, 2, 16}) {
+        for (size_t cols: {1, 3, 1024}) {
+            for (size_t unroll: {1, 2, 4, 8}) {
+                all_equal &= matvec(A, x, {rows, cols, unroll, 2}).tensor() == y_read.tensor();
+            }
+        }
+    }
+    results.push_back({all_equal, "test_kernels: matvec equal to file for all configs"});
+
+    // odd sizes so that neither blocks nor unrolling divide evenly
+    Matrix<long> B(37, 29);
+    Matrix<long> C(29, 13);
+    Vector<long> v(29);
+    for (size_t i = 0; i < 37; ++i) for (size_t j = 0; j < 29; ++j) B(i, j) = static_cast<long>(i * 3 + j) % 11 - 5;
+    for (size_t i = 0; i < 29; ++i) for (size_t j = 0; j < 13; ++j) C(i, j) = static_cast<long>(i + 2 * j) % 7 - 3;
+    for (size_t i = 0; i < 29; ++i) v(i) = static_cast<long>(i) - 10;
+
+    Matrix<long> expected(37, 13);
+    for (size_t i = 0; i < 37; ++i) {
+        for (size_t j = 0; j < 13; ++j) {
+            for (size_t k = 0; k < 29; ++k) {
+                expected(i, j) += B(i, k) * C(k, j);
+            }
+        }
+    }
+
+    bool mv_equal = true;
+    bool mm_equal = true;
+    for (const KernelConfig &config: {KernelConfig{1, 1, 1, 1}, KernelConfig{4, 5, 2, 3}, KernelConfig{8, 16, 8, 4},
+                                      KernelConfig{64, 4096, 4, 1}}) {
+        mv_equal &= matvec(B, v, config).tensor() == matvec(B, v).tensor();
+        mm_equal &= matmul(B, C, config).tensor() == expected.tensor();
+    }
+    results.push_back({mv_equal, "test_kernels: blocked matvec with uneven sizes"});
+    results.push_back({mm_equal, "test_kernels: blocked matmul with uneven sizes"});
+}
+
+void test_cache(std::vector<std::pair<bool, std::string> > &results) {
+    const std::string path = "data/tuning_cache";
+    std::filesystem::remove(path);
+
+    // no cache: heuristics, nothing is written
+    Autotuner cached(path, TuneMode::Cached);
+    const KernelConfig fallback = cached.matvecConfig<float>(100, 100, 2);
+    const KernelConfig heuristic = Autotuner(path, TuneMode::Heuristic).matvecConfig<float>(100, 100, 2);
+    results.push_back({fallback == heuristic, "test_cache: heuristics without cache"});
+    results.push_back({!std::filesystem::exists(path), "test_cache: cached mode does not write"});
+
+    // tune mode benchmarks on a miss and persists the winner
+    Autotuner tuning(path, TuneMode::Tune);
+    const KernelConfig tuned = tuning.matvecConfig<float>(40, 40, 2);
+    results.push_back({tuning.numEntries() == 1, "test_cache: tuned entry stored"});
+    results.push_back({std::filesystem::exists(path), "test_cache: tuned entry persisted"});
+    results.push_back({tuning.matvecConfig<float>(40, 40, 2) == tuned, "test_cache: second lookup hits"});
+
+    // a new process loads the winner for the whole shape class and thread count only
+    Autotuner reloaded(path, TuneMode::Cached);
+    results.push_back({reloaded.numEntries() == 1, "test_cache: entry loaded"});
+    results.push_back({reloaded.matvecConfig<float>(41, 41, 2) == tuned, "test_cache: same shape class hits"});
+    const KernelConfig heuristic_double = Autotuner(path, TuneMode::Heuristic).matvecConfig<double>(40, 40, 2);
+    results.push_back({reloaded.matvecConfig<double>(40, 40, 2) == heuristic_double, "test_cache: other dtype misses"});
+
+    // entries of other CPUs and unreadable lines are kept out of the lookup
+    {
+        std::ofstream file(path, std::ios::app);
+        file << "Some Other CPU\tmatvec f32 0 2\t1 1 1 1\n";
+        file << "garbage line\n";
+    }
+    Autotuner mixed(path, TuneMode::Cached);
+    results.push_back({mixed.numEntries() == 1, "test_cache: foreign CPU entries not used"});
+    mixed.save();
+    std::ifstream file(path);
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    results.push_back({content.find("Some Other CPU") != std::string::npos, "test_cache: foreign CPU entries kept"});
+
+    // like ~/.cache on a fresh machine, the directory of the cache file does not exist yet
+    const std::string nested_dir = path + "_dir";
+    std::filesystem::remove_all(nested_dir);
+    Autotuner nested(nested_dir + "/sub/cache", TuneMode::Tune);
+    nested.matvecConfig<float>(40, 40, 2);
+    results.push_back({std::filesystem::exists(nested_dir + "/sub/cache"), "test_cache: missing directory created"});
+    std::filesystem::remove_all(nested_dir);
+
+    std::filesystem::remove(path);
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+
+    test_kernels(results);
+    test_cache(results);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}
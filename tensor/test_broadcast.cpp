@@ -0,0 +1,117 @@
+#include "broadcast.hpp"
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+Tensor<int> makeTensor(const std::vector<size_t> &shape, int offset) {
+    Tensor<int> t(shape);
+    for (size_t i = 0; i < t.numElements(); ++i) t.Flat_idx(i) = static_cast<int>((i * 31) % 97) + offset;
+    return t;
+}
+
+// Reference through operator(): every result index mapped back to both operands.
+Tensor<int> reference(const Tensor<int> &a, const Tensor<int> &b) {
+    const auto shape = broadcastShape(a.shape(), b.shape());
+    Tensor<int> result(shape);
+    std::vector<size_t> idx(shape.size(), 0);
+    for (size_t flat = 0; flat < result.numElements(); ++flat) {
+        std::vector<size_t> ia(a.rank()), ib(b.rank());
+        for (size_t d = 0; d < a.rank(); ++d) ia[d] = a.shape()[d] == 1 ? 0 : idx[d + shape.size() - a.rank()];
+        for (size_t d = 0; d < b.rank(); ++d) ib[d] = b.shape()[d] == 1 ? 0 : idx[d + shape.size() - b.rank()];
+        result(idx) = a(ia) * 3 - b(ib);
+        for (size_t d = shape.size(); d-- > 0;) {
+            if (++idx[d] < shape[d]) break;
+            idx[d] = 0;
+        }
+    }
+    return result;
+}
+
+void test_shapes(std::vector<std::pair<bool, std::string> > &results) {
+    results.push_back({broadcastShape({8, 1, 6, 1}, {7, 1, 5}) == std::vector<size_t>{8, 7, 6, 5},
+                       "test_shapes: numpy example"});
+    results.push_back({broadcastShape({}, {2, 3}) == std::vector<size_t>{2, 3}, "test_shapes: scalar"});
+
+    bool thrown = false;
+    try {
+        broadcastShape({2, 3}, {4, 3});
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_shapes: incompatible shapes throw"});
+}
+
+void test_apply(std::vector<std::pair<bool, std::string> > &results) {
+    const std::vector<std::pair<std::vector<size_t>, std::vector<size_t> > > cases = {
+        {{4, 5}, {4, 5}},
+        {{4, 5}, {5}},
+        {{4, 1}, {1, 5}},
+        {{3, 1, 6}, {4, 1}},
+        {{2, 3, 4, 5}, {3, 1, 5}},
+        {{2, 1, 4, 1}, {1, 3, 1, 5}},
+        {{7, 1}, {1}},
+        {{1}, {2, 2, 2}},
+        {{64, 40, 30}, {40, 1}},
+        {{64, 1, 30}, {1, 40, 30}},
+    };
+    for (const auto &[sa, sb]: cases) {
+        const auto a = makeTensor(sa, 1);
+        const auto b = makeTensor(sb, -40);
+        const auto op = [](int x, int y) { return x * 3 - y; };
+        const bool equal = broadcastApply(a, b, op, 1) == reference(a, b)
+                           && broadcastApply(a, b, op, 3) == reference(a, b);
+        auto name = [](const std::vector<size_t> &shape) {
+            std::string result;
+            for (size_t d = 0; d < shape.size(); ++d) {
+                if (d) result += 'x';
+                result += std::to_string(shape[d]);
+            }
+            return result;
+        };
+        results.push_back({equal, "test_apply: " + name(sa) + " with " + name(sb)});
+    }
+}
+
+void test_arithmetic(std::vector<std::pair<bool, std::string> > &results) {
+    // softmax style: subtract the row maximum, divide by a column of sums
+    Tensor<double> x({2, 3});
+    for (size_t i = 0; i < 6; ++i) x.Flat_idx(i) = static_cast<double>(i);
+    Tensor<double> row_max({2, 1});
+    row_max({0, 0}) = 2;
+    row_max({1, 0}) = 5;
+    const auto shifted = subtract(x, row_max);
+    results.push_back({shifted({0, 0}) == -2 && shifted({1, 2}) == 0, "test_arithmetic: subtract column"});
+
+    const auto scaled = multiply(x, Tensor<double>({3}, 2.0));
+    results.push_back({scaled({1, 1}) == 8, "test_arithmetic: multiply row"});
+    results.push_back({add(x, Tensor<double>({}, 1.0))({0, 2}) == 3, "test_arithmetic: add scalar"});
+    results.push_back({divide(x, Tensor<double>({2, 1}, 2.0))({1, 0}) == 1.5, "test_arithmetic: divide"});
+    results.push_back({maximum(x, Tensor<double>({}, 2.5))({0, 0}) == 2.5, "test_arithmetic: maximum"});
+    results.push_back({add(x, Tensor<double>({0, 1, 3})).shape() == std::vector<size_t>{0, 2, 3},
+                       "test_arithmetic: empty result"});
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+
+    test_shapes(results);
+    test_apply(results);
+    test_arithmetic(results);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}
@@ -0,0 +1,105 @@
+#include "eigen_interop.hpp"
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+void test_tensor_to_eigen(std::vector<std::pair<bool, std::string> > &results) {
+    auto a = readTensorFromFile<int>("data/matrix");
+    auto m = asEigen(a);
+
+    results.push_back({m.data() == a.data(), "test_tensor_to_eigen: no copy"});
+    results.push_back({m(1, 2) == a({1, 2}) && m(2, 0) == a({2, 0}), "test_tensor_to_eigen: row-major mapping"});
+
+    m(0, 1) = 17;
+    results.push_back({a({0, 1}) == 17, "test_tensor_to_eigen: writes reach the tensor"});
+
+    // matvec through Eigen on tensor storage
+    auto x = readTensorFromFile<int>("data/vector_in");
+    auto y = readTensorFromFile<int>("data/vector_out");
+    auto A = readTensorFromFile<int>("data/matrix");
+    const Tensor<int> &constA = A;
+    Tensor<int> y_comp({A.shape()[0]});
+    asEigenVector(y_comp) = asEigen(constA) * asEigenVector(x);
+    results.push_back({y_comp == y, "test_tensor_to_eigen: Eigen product into tensor"});
+
+    Tensor<float> t({2, 3, 4});
+    results.push_back({asEigenVector(t).size() == 24, "test_tensor_to_eigen: any rank as vector"});
+
+    bool thrown = false;
+    try {
+        asEigen(t);
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_tensor_to_eigen: rank 3 cannot be a matrix"});
+}
+
+void test_eigen_to_tensor(std::vector<std::pair<bool, std::string> > &results) {
+    Eigen::MatrixXd col_major(3, 4);
+    RowMajorMatrix<double> row_major(3, 4);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            col_major(i, j) = row_major(i, j) = 10 * i + j;
+        }
+    }
+
+    auto cv = asTensorView(col_major);
+    auto rv = asTensorView(row_major);
+    results.push_back({cv.data() == col_major.data() && rv.data() == row_major.data(), "test_eigen_to_tensor: no copy"});
+    results.push_back({cv({2, 1}) == 21 && rv({2, 1}) == 21, "test_eigen_to_tensor: element mapping"});
+    results.push_back({rv.isContiguous() && !cv.isContiguous(), "test_eigen_to_tensor: contiguity"});
+    results.push_back({cv.toTensor() == rv.toTensor(), "test_eigen_to_tensor: same tensor for both orders"});
+
+    cv({0, 3}) = -1;
+    results.push_back({col_major(0, 3) == -1, "test_eigen_to_tensor: writes reach the matrix"});
+
+    auto block = asTensorView(col_major.block(1, 1, 2, 2));
+    results.push_back({block({1, 0}) == 21 && block.shape()[0] == 2, "test_eigen_to_tensor: block view"});
+
+    // strided view back to Eigen
+    auto back = asEigen(cv);
+    results.push_back({back(2, 3) == col_major(2, 3) && back.data() == col_major.data(),
+                       "test_eigen_to_tensor: view maps back to Eigen"});
+}
+
+void test_image_rows(std::vector<std::pair<bool, std::string> > &results) {
+    // like loadMnistImages: one flattened 2 x 3 image per row of a column-major matrix
+    Eigen::MatrixXd images(4, 6);
+    for (int i = 0; i < 4; ++i) {
+        for (int p = 0; p < 6; ++p) {
+            images(i, p) = 100 * i + p;
+        }
+    }
+    auto image = rowAsTensorView(images, 2, 2, 3);
+    results.push_back({image({1, 0}) == 203 && image({0, 2}) == 202, "test_image_rows: pixels in row-major order"});
+    results.push_back({image.data() == images.data() + 2, "test_image_rows: no copy"});
+
+    RowMajorMatrix<double> contiguous = images;
+    results.push_back({rowAsTensorView(contiguous, 2, 2, 3).isContiguous(), "test_image_rows: row-major rows are contiguous"});
+    results.push_back({rowAsTensorView(contiguous, 2, 2, 3).toTensor() == image.toTensor(), "test_image_rows: same image"});
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+
+    test_tensor_to_eigen(results);
+    test_eigen_to_tensor(results);
+    test_image_rows(results);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}
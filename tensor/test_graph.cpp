@@ -0,0 +1,170 @@
+#include "graph.hpp"
+#include "matvec.hpp"
+#include "tensor.hpp"
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+void test_matvec(std::vector<std::pair<bool, std::string> > &results) {
+    Matrix<int> A("data/matrix");
+    Vector<int> x("data/vector_in");
+    Vector<int> y_read("data/vector_out");
+
+    Graph<int> g;
+    auto y = g.matvec(g.input(A.tensor()), g.input(x.tensor()));
+    g.compile({y});
+    auto out = g.run();
+
+    results.push_back({out[0] == y_read.tensor(), "test_graph: matvec equal to file"});
+    results.push_back({g.numKernels() == 1, "test_graph: single kernel"});
+    results.push_back({g.arenaBytes() == 0, "test_graph: outputs do not use the arena"});
+}
+
+void test_fusion(std::vector<std::pair<bool, std::string> > &results) {
+    // two dense layers: relu(W1 x + b1) -> W2 h + b2, scaled
+    Tensor<int> W1({4, 3});
+    Tensor<int> b1({4});
+    Tensor<int> W2({2, 4});
+    Tensor<int> b2({2});
+    Tensor<int> x({3});
+    for (size_t i = 0; i < W1.numElements(); ++i) W1.Flat_idx(i) = static_cast<int>(i % 5) - 2;
+    for (size_t i = 0; i < W2.numElements(); ++i) W2.Flat_idx(i) = static_cast<int>(i % 3) - 1;
+    for (size_t i = 0; i < b1.numElements(); ++i) b1.Flat_idx(i) = static_cast<int>(i) - 1;
+    for (size_t i = 0; i < b2.numElements(); ++i) b2.Flat_idx(i) = 3;
+    for (size_t i = 0; i < x.numElements(); ++i) x.Flat_idx(i) = static_cast<int>(i) + 1;
+
+    Graph<int> g;
+    auto h = g.relu(g.add(g.matvec(g.input(W1), g.input(x)), g.input(b1)));
+    // bias on the left to check the chain is found through either operand
+    auto y = g.scale(g.add(g.input(b2), g.matvec(g.input(W2), h)), 2);
+    g.compile({y});
+    auto lazy = g.run();
+    auto eager = g.runEager({y});
+
+    Tensor<int> expected({2});
+    for (size_t r = 0; r < 2; ++r) {
+        int acc = 0;
+        for (size_t c = 0; c < 4; ++c) {
+            int hidden = 0;
+            for (size_t k = 0; k < 3; ++k) {
+                hidden += W1({c, k}) * x({k});
+            }
+            acc += W2({r, c}) * std::max(hidden + b1({c}), 0);
+        }
+        expected({r}) = 2 * (acc + b2({r}));
+    }
+
+    results.push_back({lazy[0] == expected, "test_graph: fused dense layers correct"});
+    results.push_back({eager[0] == expected, "test_graph: eager dense layers correct"});
+    results.push_back({g.numKernels() == 2, "test_graph: elementwise ops fused into matvec epilogue"});
+    results.push_back({g.arenaBytes() <= g.eagerBytes(), "test_graph: arena not larger than eager"});
+
+    // running twice reuses the plan
+    results.push_back({g.run()[0] == expected, "test_graph: plan can be rerun"});
+}
+
+void test_matmul(std::vector<std::pair<bool, std::string> > &results) {
+    Tensor<double> a({3, 4});
+    Tensor<double> b({4, 2});
+    for (size_t i = 0; i < a.numElements(); ++i) a.Flat_idx(i) = 0.5 * static_cast<double>(i);
+    for (size_t i = 0; i < b.numElements(); ++i) b.Flat_idx(i) = 1.0 - static_cast<double>(i);
+
+    Graph<double> g;
+    auto A = g.input(a);
+    auto B = g.input(b);
+    auto ab = g.matmul(A, B);
+    // ab is needed twice, so it has to be materialised and cannot be fused
+    auto out = g.relu(g.mul(ab, ab));
+    auto out2 = g.scale(ab, -1.0);
+    g.compile({out, out2});
+    auto lazy = g.run();
+    auto eager = g.runEager({out, out2});
+
+    Tensor<double> expected({3, 2});
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            for (size_t k = 0; k < 4; ++k) {
+                expected({i, j}) += a({i, k}) * b({k, j});
+            }
+        }
+    }
+    Tensor<double> squared({3, 2});
+    Tensor<double> negated({3, 2});
+    for (size_t i = 0; i < expected.numElements(); ++i) {
+        squared.Flat_idx(i) = expected.Flat_idx(i) * expected.Flat_idx(i);
+        negated.Flat_idx(i) = -expected.Flat_idx(i);
+    }
+
+    results.push_back({lazy[0] == squared && lazy[1] == negated, "test_graph: matmul with shared result"});
+    results.push_back({eager[0] == squared && eager[1] == negated, "test_graph: eager matmul with shared result"});
+    results.push_back({g.numKernels() == 3, "test_graph: shared result is not fused"});
+}
+
+void test_arena_reuse(std::vector<std::pair<bool, std::string> > &results) {
+    // a chain of layers only ever needs two intermediates alive at once
+    Tensor<float> W({64, 64}, 0.01f);
+    Tensor<float> x({64}, 1.0f);
+    Graph<float> g;
+    auto w = g.input(W);
+    auto h = g.input(x);
+    for (int layer = 0; layer < 8; ++layer) {
+        h = g.relu(g.matvec(w, h));
+    }
+    g.compile({h});
+    g.run();
+
+    results.push_back({g.numKernels() == 8, "test_graph: one kernel per layer"});
+    results.push_back({g.arenaBytes() == 2 * 64 * sizeof(float), "test_graph: intermediates share the arena"});
+    results.push_back({g.eagerBytes() == 15 * 64 * sizeof(float), "test_graph: eager materialises every intermediate"});
+}
+
+void test_errors(std::vector<std::pair<bool, std::string> > &results) {
+    Tensor<int> m({2, 3});
+    Tensor<int> v({2});
+    Graph<int> g;
+    auto M = g.input(m);
+    auto V = g.input(v);
+
+    bool thrown = false;
+    try {
+        g.matvec(M, V);
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_graph: shape mismatch throws"});
+
+    thrown = false;
+    try {
+        g.run();
+    } catch (const std::logic_error &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_graph: run before compile throws"});
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+
+    test_matvec(results);
+    test_fusion(results);
+    test_matmul(results);
+    test_arena_reuse(results);
+    test_errors(results);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}
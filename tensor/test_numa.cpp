@@ -0,0 +1,118 @@
+#include "kernels.hpp"
+#include "numa.hpp"
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+void test_schedule(std::vector<std::pair<bool, std::string> > &results) {
+    // static parts are contiguous, whole grains and cover the range exactly once
+    bool covered = true;
+    for (size_t threads: {1, 3, 8}) {
+        size_t expected = 5;
+        for (size_t t = 0; t < threads; ++t) {
+            const auto [first, last] = staticRange(5, 100, 7, threads, t);
+            covered &= first == expected && first <= last && ((first - 5) % 7 == 0 || first == 100);
+            expected = last;
+        }
+        covered &= expected == 100;
+    }
+    results.push_back({covered, "test_schedule: static ranges partition the range"});
+
+    for (ThreadAffinity affinity: {ThreadAffinity::None, ThreadAffinity::Compact, ThreadAffinity::Spread}) {
+        setThreadAffinity(affinity);
+        std::vector<std::atomic<int>> visits(1000);
+        parallelFor(0, 1000, 16, 4, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                ++visits[i];
+            }
+        });
+        bool once = true;
+        for (auto &v: visits) {
+            once &= v == 1;
+        }
+        results.push_back({once, "test_schedule: every index visited once"});
+    }
+    setThreadAffinity(ThreadAffinity::None);
+
+    // serial calls, also nested in pinned workers, run on the thread that makes them
+    setThreadAffinity(ThreadAffinity::Spread);
+    bool inline_serial = true;
+    const auto caller = std::this_thread::get_id();
+    parallelFor(0, 10, 10, 1, [&](size_t, size_t) {
+        inline_serial &= std::this_thread::get_id() == caller;
+    });
+    std::atomic<bool> nested_inline{true};
+    parallelFor(0, 8, 1, 4, [&](size_t, size_t) {
+        const auto worker = std::this_thread::get_id();
+        parallelFor(0, 100, 1, 1, [&](size_t, size_t) {
+            if (std::this_thread::get_id() != worker) nested_inline = false;
+        });
+    });
+    setThreadAffinity(ThreadAffinity::None);
+    results.push_back({inline_serial, "test_schedule: pinned serial call runs on the caller"});
+    results.push_back({nested_inline, "test_schedule: nested serial call runs on its worker"});
+
+    results.push_back({affinityCpus(ThreadAffinity::Spread).size() == affinityCpus(ThreadAffinity::Compact).size(),
+                       "test_schedule: spread and compact use the same cpus"});
+}
+
+void test_placement(std::vector<std::pair<bool, std::string> > &results) {
+    results.push_back({numaNodes() >= 1, "test_placement: at least one node"});
+
+    Tensor<double> a({300, 1000});
+    for (size_t i = 0; i < a.numElements(); ++i) a.Flat_idx(i) = static_cast<double>(i);
+    const Tensor<double> reference = a;
+
+    setThreadAffinity(ThreadAffinity::Compact);
+    const bool interleaved = placeTensor(a, NumaPolicy::Interleave);
+    const bool partitioned = placeTensor(a, NumaPolicy::Partitioned, 4, 16);
+    const bool untouched = placeTensor(a, NumaPolicy::Default);
+    setThreadAffinity(ThreadAffinity::None);
+
+    results.push_back({a == reference, "test_placement: data unchanged by migration"});
+    results.push_back({interleaved == numaEnabled() && partitioned == numaEnabled(),
+                       "test_placement: pages only moved with several nodes"});
+    results.push_back({!untouched, "test_placement: default policy leaves pages"});
+    results.push_back({!placeTensor(a, NumaPolicy::Partitioned, 4, 16),
+                       "test_placement: partitioned leaves pages of unpinned workers"});
+
+    NumaReplicas<double> replicas(reference);
+    results.push_back({replicas.numReplicas() == (numaEnabled() ? numaNodes() : 1), "test_placement: one replica per node"});
+    results.push_back({replicas.local() == reference, "test_placement: local replica equals source"});
+}
+
+void test_pinned_kernels(std::vector<std::pair<bool, std::string> > &results) {
+    Matrix<int> A("data/matrix");
+    Vector<int> x("data/vector_in");
+    Vector<int> y_read("data/vector_out");
+
+    setThreadAffinity(ThreadAffinity::Spread);
+    const bool equal = matvec(A, x, {1, 2, 1, 3}).tensor() == y_read.tensor();
+    setThreadAffinity(ThreadAffinity::None);
+    results.push_back({equal, "test_pinned_kernels: matvec with pinned workers"});
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+
+    test_schedule(results);
+    test_placement(results);
+    test_pinned_kernels(results);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}
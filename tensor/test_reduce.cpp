@@ -0,0 +1,144 @@
+#include "reduce.hpp"
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+// Next index in row-major order, false after the last one.
+bool nextIndex(std::vector<size_t> &idx, const std::vector<size_t> &shape) {
+    for (size_t d = shape.size(); d-- > 0;) {
+        if (++idx[d] < shape[d]) {
+            return true;
+        }
+        idx[d] = 0;
+    }
+    return false;
+}
+
+// Straightforward reduction through operator(), the reference for the blocked one.
+template<class T, class Combine>
+Tensor<T> reference(const Tensor<T> &tensor, size_t axis, T init, Combine combine) {
+    auto shape = tensor.shape();
+    Tensor<T> result(reducedShape(shape, axis, true), init);
+    std::vector<size_t> idx(shape.size(), 0);
+    do {
+        auto out = idx;
+        out[axis] = 0;
+        result(out) = combine(result(out), tensor(idx));
+    } while (nextIndex(idx, shape));
+    return result;
+}
+
+Tensor<long> makeTensor(const std::vector<size_t> &shape) {
+    Tensor<long> t(shape);
+    for (size_t i = 0; i < t.numElements(); ++i) t.Flat_idx(i) = static_cast<long>((i * 7919) % 1009) - 500;
+    return t;
+}
+
+void test_sum(std::vector<std::pair<bool, std::string> > &results) {
+    // more inner elements than one block, and enough elements for several chunks
+    for (const std::vector<size_t> &shape: {std::vector<size_t>{7}, {5, 9}, {3, 4, 5}, {2, 3, 4, 5}, {3, 2, 1100},
+                                            {40, 30, 64}}) {
+        const auto t = makeTensor(shape);
+        bool equal = true;
+        bool kept = true;
+        for (size_t axis = 0; axis < shape.size(); ++axis) {
+            const auto expected = reference<long>(t, axis, 0, [](long a, long b) { return a + b; });
+            for (size_t threads: {1, 3}) {
+                const auto keep = sum(t, axis, true, threads);
+                equal &= keep == expected;
+                kept &= sum(t, axis, false, threads).shape() == reducedShape(shape, axis, false);
+            }
+        }
+        results.push_back({equal && kept, "test_sum: rank " + std::to_string(shape.size()) + ", "
+                                          + std::to_string(t.numElements()) + " elements"});
+    }
+
+    bool thrown = false;
+    try {
+        sum(makeTensor({2, 3}), 2);
+    } catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_sum: axis out of range throws"});
+    results.push_back({sum(Tensor<long>({4, 0, 3}), 1) == Tensor<long>({4, 3}), "test_sum: empty axis is 0"});
+}
+
+void test_mean(std::vector<std::pair<bool, std::string> > &results) {
+    Tensor<int> t({2, 3});
+    for (size_t i = 0; i < 6; ++i) t.Flat_idx(i) = static_cast<int>(i);
+    const Tensor<double> m = mean(t, 1);
+    results.push_back({m.shape() == std::vector<size_t>{2} && m({0}) == 1.0 && m({1}) == 4.0,
+                       "test_mean: integers average in double"});
+    const auto f = mean(Tensor<float>({4, 2}, 0.5f), 0, true);
+    results.push_back({f == Tensor<float>({1, 2}, 0.5f), "test_mean: float, keepdims"});
+}
+
+void test_max(std::vector<std::pair<bool, std::string> > &results) {
+    bool equal = true;
+    bool indices = true;
+    for (const std::vector<size_t> &shape: {std::vector<size_t>{6, 5}, {3, 4, 5}, {2, 3, 4, 5}, {2, 3, 1500},
+                                            {40, 30, 64}}) {
+        const auto t = makeTensor(shape);
+        for (size_t axis = 0; axis < shape.size(); ++axis) {
+            const auto expected = reference<long>(t, axis, std::numeric_limits<long>::lowest(),
+                                                  [](long a, long b) { return std::max(a, b); });
+            equal &= max(t, axis, true, 2) == expected;
+
+            // the element at the returned index is the maximum
+            const auto index = argmax(t, axis, true, 2);
+            std::vector<size_t> idx(shape.size(), 0);
+            const auto out_shape = index.shape();
+            do {
+                auto at = idx;
+                at[axis] = index(idx);
+                indices &= t(at) == expected(idx);
+            } while (nextIndex(idx, out_shape));
+        }
+    }
+    results.push_back({equal, "test_max: every axis"});
+    results.push_back({indices, "test_argmax: every axis"});
+
+    Tensor<float> ties({2, 3}, 1.0f);
+    ties({1, 0}) = -1.0f;
+    const auto rows = argmax(ties, 1);
+    const auto cols = argmax(ties, 0);
+    results.push_back({rows({0}) == 0 && rows({1}) == 1 && cols({0}) == 0 && cols({2}) == 0,
+                       "test_argmax: first of equal maxima"});
+
+    Tensor<double> negative({3}, -std::numeric_limits<double>::infinity());
+    results.push_back({max(negative, 0)({}) == -std::numeric_limits<double>::infinity(),
+                       "test_max: all -inf"});
+
+    bool thrown = false;
+    try {
+        argmax(Tensor<int>({3, 0}), 1);
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_argmax: empty axis throws"});
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+
+    test_sum(results);
+    test_mean(results);
+    test_max(results);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}
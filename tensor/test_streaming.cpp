@@ -0,0 +1,154 @@
+#include <filesystem>
+
+#include "streaming.hpp"
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+void test_text(std::vector<std::pair<bool, std::string> > &results) {
+    Vector<int> x("data/vector_in");
+    Vector<int> y_read("data/vector_out");
+
+    bool equal = true;
+    for (size_t panel_rows: {1, 2, 100}) {
+        StreamConfig config;
+        config.panel_rows = panel_rows;
+        equal &= streamingMatvec("data/matrix", x, config).tensor() == y_read.tensor();
+    }
+    results.push_back({equal, "test_text: streamed matvec equal to file"});
+
+    // a chunk boundary has to be able to cut through a number
+    Tensor<double> a({50, 31});
+    for (size_t i = 0; i < a.numElements(); ++i) a.Flat_idx(i) = static_cast<double>(i) * 0.25 - 100.0;
+    writeTensorToFile(a, "data/stream_text");
+    Vector<double> v(31, 0.5);
+    StreamConfig config;
+    config.panel_rows = 7;
+    auto streamed = streamingMatvec("data/stream_text", v, config);
+    Vector<double> expected(50);
+    for (size_t i = 0; i < 50; ++i) for (size_t j = 0; j < 31; ++j) expected(i) += a({i, j}) * 0.5;
+    results.push_back({streamed.tensor() == expected.tensor(), "test_text: fractional values"});
+
+    // chunks of a few bytes refill inside almost every number, 3 bytes is shorter than most
+    bool chunked = true;
+    for (size_t chunk_bytes: {3, 7, 64}) {
+        TextPanelSource<double> source("data/stream_text", chunk_bytes);
+        std::vector<double> buffer(7 * 31);
+        size_t row = 0;
+        while (true) {
+            const auto [panel, rows] = source.next(buffer.data(), 7);
+            if (rows == 0) {
+                break;
+            }
+            for (size_t i = 0; i < rows * 31; ++i) chunked &= panel[i] == a.Flat_idx(row * 31 + i);
+            row += rows;
+        }
+        chunked &= row == 50;
+    }
+    results.push_back({chunked, "test_text: numbers cut at small chunk boundaries"});
+    std::filesystem::remove("data/stream_text");
+}
+
+void test_binary(std::vector<std::pair<bool, std::string> > &results) {
+    Matrix<long> A(103, 37);
+    Matrix<long> B(37, 5);
+    Vector<long> v(37);
+    for (size_t i = 0; i < 103; ++i) for (size_t j = 0; j < 37; ++j) A(i, j) = static_cast<long>(i * j % 13) - 6;
+    for (size_t i = 0; i < 37; ++i) for (size_t j = 0; j < 5; ++j) B(i, j) = static_cast<long>(i + j) % 5 - 2;
+    for (size_t i = 0; i < 37; ++i) v(i) = static_cast<long>(i) - 18;
+
+    writeTensorToBinaryFile(A.tensor(), "data/stream_bin");
+    results.push_back({isBinaryTensorFile("data/stream_bin") && !isBinaryTensorFile("data/matrix"),
+                       "test_binary: format detection"});
+    results.push_back({readTensorFromBinaryFile<long>("data/stream_bin") == A.tensor(), "test_binary: round trip"});
+
+    const auto mv = matvec(A, v);
+    const auto mm = matmul(A, B, KernelConfig{});
+    bool mv_equal = true;
+    bool mm_equal = true;
+    for (bool use_mmap: {false, true}) {
+        for (size_t panel_rows: {1, 10, 103, 1000}) {
+            StreamConfig config;
+            config.panel_rows = panel_rows;
+            config.use_mmap = use_mmap;
+            mv_equal &= streamingMatvec("data/stream_bin", v, config).tensor() == mv.tensor();
+            mm_equal &= streamingMatmul("data/stream_bin", B, config).tensor() == mm.tensor();
+        }
+    }
+    results.push_back({mv_equal, "test_binary: streamed matvec, read and mmap"});
+    results.push_back({mm_equal, "test_binary: streamed matmul, read and mmap"});
+
+    // panel size from the memory budget
+    StreamConfig budget;
+    budget.memory_budget = 2 * 37 * sizeof(long) * 3;
+    results.push_back({streamingMatvec("data/stream_bin", v, budget).tensor() == mv.tensor(),
+                       "test_binary: panels from memory budget"});
+
+    bool thrown = false;
+    try {
+        streamingMatvec("data/stream_bin", Vector<long>(36));
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_binary: shape mismatch throws"});
+
+    thrown = false;
+    try {
+        readTensorFromBinaryFile<float>("data/stream_bin");
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_binary: wrong component type throws"});
+
+    // header intact, data cut after 10 rows; mapping it must not read past the end of the file
+    std::filesystem::resize_file("data/stream_bin", 64 + 10 * 37 * sizeof(long));
+    bool truncated = true;
+    for (bool use_mmap: {false, true}) {
+        StreamConfig config;
+        config.panel_rows = 8;
+        config.use_mmap = use_mmap;
+        thrown = false;
+        try {
+            streamingMatvec("data/stream_bin", v, config);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        truncated &= thrown;
+    }
+    results.push_back({truncated, "test_binary: truncated file throws, read and mmap"});
+    std::filesystem::remove("data/stream_bin");
+}
+
+void test_convert(std::vector<std::pair<bool, std::string> > &results) {
+    StreamConfig config;
+    config.panel_rows = 2;
+    convertTextToBinary<int>("data/matrix", "data/stream_converted", config);
+    results.push_back({readTensorFromBinaryFile<int>("data/stream_converted") == readTensorFromFile<int>("data/matrix"),
+                       "test_convert: text to binary"});
+    std::filesystem::remove("data/stream_converted");
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+
+    test_text(results);
+    test_binary(results);
+    test_convert(results);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}
@@ -0,0 +1,71 @@
+#include "tensor.hpp"
+#include "tensor_view.hpp"
+
+void check(bool condition, const std::string &msg) {
+    if (!condition) {
+        std::cout << "FAILED: " << msg << "\n";
+    } else {
+        std::cout << "PASSED: " << msg << "\n";
+    }
+}
+
+void test_view(std::vector<std::pair<bool, std::string> > &results) {
+    auto a = readTensorFromFile<int>("data/tensor_02");
+    TensorView<int> v(a);
+
+    results.push_back({v.data() == a.data(), "test_view: shares storage"});
+    results.push_back({v.isContiguous(), "test_view: tensor view is contiguous"});
+    results.push_back({v({1, 0, 1}) == a({1, 0, 1}), "test_view: same element as tensor"});
+
+    v({0, 1, 0}) = 42;
+    results.push_back({a({0, 1, 0}) == 42, "test_view: writes reach the tensor"});
+    results.push_back({v.toTensor() == a, "test_view: copy equals tensor"});
+
+    const Tensor<int> &c = a;
+    TensorView<const int> cv(c);
+    results.push_back({cv({1, 1, 1}) == a({1, 1, 1}), "test_view: read-only view"});
+}
+
+void test_strided(std::vector<std::pair<bool, std::string> > &results) {
+    // column-major 2 x 3 storage: {{1, 2, 3}, {4, 5, 6}}
+    std::vector<double> storage = {1, 4, 2, 5, 3, 6};
+    TensorView<double> v(storage.data(), {2, 3}, {1, 2});
+
+    results.push_back({!v.isContiguous(), "test_strided: column-major is not contiguous"});
+    results.push_back({v({0, 2}) == 3 && v({1, 0}) == 4, "test_strided: strided access"});
+
+    Tensor<double> expected({2, 3});
+    for (size_t i = 0; i < 6; ++i) expected.Flat_idx(i) = static_cast<double>(i + 1);
+    results.push_back({v.toTensor() == expected, "test_strided: copy is row-major"});
+
+    // every second column
+    TensorView<double> sub(storage.data(), {2, 2}, {1, 4});
+    results.push_back({sub({1, 1}) == 6 && sub({0, 1}) == 3, "test_strided: sub view"});
+
+    bool thrown = false;
+    try {
+        v({2, 0});
+    } catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    results.push_back({thrown, "test_strided: out of bounds throws"});
+}
+
+int main() {
+    std::vector<std::pair<bool, std::string> > results;
+
+    test_view(results);
+    test_strided(results);
+
+    size_t passed = 0;
+    for (auto [condition, msg]: results) {
+        check(condition, msg);
+        if (condition) {
+            passed++;
+        }
+    }
+
+    std::cout << "--- " << passed << "/" << results.size() << " checks passed ---" << std::endl;
+
+    return passed != results.size();
+}